@@ -0,0 +1,374 @@
+// NOTE: Microbenchmarks for the math layer, support queries over a
+// large hull set, the mesh BVH build and the collision world step.
+// This is a separate program that doesn't depend on SDL. Build it with
+// and without MATH_SIMD=1 to compare both backends.
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+#include "gjk_mesh.hh"
+#include "gjk_world.hh"
+#include "jobs.hh"
+#include "thread.hh"
+
+// ----------------------------------------------------------------
+// Data
+// ----------------------------------------------------------------
+
+#define BENCH_COUNT 4096
+#define BENCH_ROUNDS 2048
+
+static u32 bench_rng_state = 0x12345678;
+
+static
+f32 bench_random(void){
+	// NOTE: xorshift32 mapped to [-1, 1]
+	u32 x = bench_rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	bench_rng_state = x;
+	return (f32)((f64)x / (f64)UINT32_MAX) * 2.0f - 1.0f;
+}
+
+static
+Vector3 bench_random_v3(void){
+	f32 x = bench_random();
+	f32 y = bench_random();
+	f32 z = bench_random();
+	return make_v3(x, y, z);
+}
+
+static Vector3 bench_a[BENCH_COUNT];
+static Vector3 bench_b[BENCH_COUNT];
+static Vector3 bench_c[BENCH_COUNT];
+static Vector3 bench_out[BENCH_COUNT];
+static Quaternion bench_q[BENCH_COUNT];
+static Matrix4 bench_m[BENCH_COUNT];
+static Matrix4 bench_mout[BENCH_COUNT];
+static f32 bench_soa_in[3][BENCH_COUNT];
+static f32 bench_soa_out[3][BENCH_COUNT];
+
+// NOTE: Results are accumulated here and printed at the end so the
+// compiler can't throw away the work being measured.
+static f32 bench_sink;
+
+static
+void bench_init(void){
+	for(i32 i = 0; i < BENCH_COUNT; i += 1){
+		bench_a[i] = bench_random_v3();
+		bench_b[i] = bench_random_v3();
+		bench_c[i] = bench_random_v3();
+		bench_q[i] = quat_angle_axis(
+			(f32)CONST_PI * bench_random(),
+			bench_random_v3() + make_v3(0.0f, 0.0f, 2.0f));
+		bench_m[i] = mat4_from_quat(bench_q[i])
+			* mat4_translation(bench_random_v3());
+		bench_soa_in[0][i] = bench_a[i].x;
+		bench_soa_in[1][i] = bench_a[i].y;
+		bench_soa_in[2][i] = bench_a[i].z;
+	}
+}
+
+static
+void bench_report(const char *name, f64 elapsed){
+	f64 ns_per_op = 1.0e9 * elapsed / ((f64)BENCH_COUNT * (f64)BENCH_ROUNDS);
+	printf("  %-16s %8.3f ns/op\n", name, ns_per_op);
+}
+
+// ----------------------------------------------------------------
+// Benchmarks
+// ----------------------------------------------------------------
+
+static
+void bench_v3_dot(void){
+	f32 acc = 0.0f;
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1){
+		for(i32 i = 0; i < BENCH_COUNT; i += 1)
+			acc += v3_dot(bench_a[i], bench_b[i]);
+	}
+	bench_report("v3_dot", thread_time() - start);
+	bench_sink += acc;
+}
+
+static
+void bench_v3_cross(void){
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1){
+		for(i32 i = 0; i < BENCH_COUNT; i += 1)
+			bench_out[i] = v3_cross(bench_a[i], bench_b[i]);
+	}
+	bench_report("v3_cross", thread_time() - start);
+	bench_sink += bench_out[BENCH_COUNT - 1].x;
+}
+
+static
+void bench_v3_triple_cross(void){
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1){
+		for(i32 i = 0; i < BENCH_COUNT; i += 1)
+			bench_out[i] = v3_triple_cross(bench_a[i], bench_b[i], bench_c[i]);
+	}
+	bench_report("v3_triple_cross", thread_time() - start);
+	bench_sink += bench_out[BENCH_COUNT - 1].x;
+}
+
+static
+void bench_v3_normalize(void){
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1){
+		for(i32 i = 0; i < BENCH_COUNT; i += 1)
+			bench_out[i] = v3_normalize(bench_c[i]);
+	}
+	bench_report("v3_normalize", thread_time() - start);
+	bench_sink += bench_out[BENCH_COUNT - 1].x;
+}
+
+static
+void bench_v3_rotate(void){
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1){
+		for(i32 i = 0; i < BENCH_COUNT; i += 1)
+			bench_out[i] = v3_rotate(bench_a[i], bench_q[i]);
+	}
+	bench_report("v3_rotate", thread_time() - start);
+	bench_sink += bench_out[BENCH_COUNT - 1].x;
+}
+
+static
+void bench_mat4_mul(void){
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1){
+		for(i32 i = 0; i < BENCH_COUNT; i += 1)
+			bench_mout[i] = bench_m[i] * bench_m[(i + r) & (BENCH_COUNT - 1)];
+	}
+	bench_report("mat4 * mat4", thread_time() - start);
+	bench_sink += bench_mout[BENCH_COUNT - 1].m[0];
+}
+
+static
+void bench_mat4_transform(void){
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1){
+		for(i32 i = 0; i < BENCH_COUNT; i += 1)
+			bench_out[i] = bench_m[i] * bench_a[i];
+	}
+	bench_report("mat4 * v3", thread_time() - start);
+	bench_sink += bench_out[BENCH_COUNT - 1].x;
+}
+
+static
+void bench_transform_points(void){
+	Transform t = make_transform(bench_q[0], bench_b[0]);
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1)
+		transform_points(t, bench_a, bench_out, BENCH_COUNT);
+	bench_report("transform (AoS)", thread_time() - start);
+	bench_sink += bench_out[BENCH_COUNT - 1].x;
+}
+
+static
+void bench_transform_points_soa(void){
+	Transform t = make_transform(bench_q[0], bench_b[0]);
+	Vector3SoA in = make_v3soa(bench_soa_in[0], bench_soa_in[1], bench_soa_in[2]);
+	Vector3SoA out = make_v3soa(bench_soa_out[0], bench_soa_out[1], bench_soa_out[2]);
+	f64 start = thread_time();
+	for(i32 r = 0; r < BENCH_ROUNDS; r += 1)
+		transform_points_soa(t, in, out, BENCH_COUNT);
+	bench_report("transform (SoA)", thread_time() - start);
+	bench_sink += bench_soa_out[0][BENCH_COUNT - 1];
+}
+
+// ----------------------------------------------------------------
+// Hull Set
+// ----------------------------------------------------------------
+// NOTE: Enough hulls to not fit in cache, each queried once per pass
+// in a random direction and in a scattered order, like pairs coming out
+// of a broadphase. This is memory bound so it compares packed Vector3
+// points with quantized points.
+#define BENCH_HULL_COUNT 32768
+#define BENCH_HULL_POINTS 32
+#define BENCH_HULL_PASSES 8
+
+static
+void bench_hull_support(void){
+	static_assert(IS_POWER_OF_TWO(BENCH_HULL_COUNT), "");
+	usize quantized_stride = (gjk_quantized_size(BENCH_HULL_POINTS) + 15) & ~(usize)15;
+	Vector3 *points = (Vector3*)malloc(sizeof(Vector3) * BENCH_HULL_COUNT * BENCH_HULL_POINTS);
+	u8 *quantized = (u8*)malloc(quantized_stride * BENCH_HULL_COUNT);
+	GJK_Polygon *polygons = (GJK_Polygon*)malloc(sizeof(GJK_Polygon) * BENCH_HULL_COUNT);
+	GJK_Polygon *qpolygons = (GJK_Polygon*)malloc(sizeof(GJK_Polygon) * BENCH_HULL_COUNT);
+	ASSERT(points != NULL && quantized != NULL && polygons != NULL && qpolygons != NULL);
+	for(i32 i = 0; i < BENCH_HULL_COUNT; i += 1){
+		Vector3 *hull = &points[i * BENCH_HULL_POINTS];
+		Vector3 center = 100.0f * bench_random_v3();
+		for(i32 j = 0; j < BENCH_HULL_POINTS; j += 1)
+			hull[j] = center + bench_random_v3();
+		polygons[i] = make_gjk_polygon(hull, BENCH_HULL_POINTS);
+		GJK_Quantized *q = gjk_quantize(&polygons[i], quantized + quantized_stride * i);
+		qpolygons[i] = make_gjk_polygon_quantized(q, BENCH_HULL_POINTS);
+	}
+
+	for(i32 k = 0; k < 2; k += 1){
+		GJK_Polygon *set = k == 0 ? polygons : qpolygons;
+		i32 acc = 0;
+		f64 start = thread_time();
+		for(i32 r = 0; r < BENCH_HULL_PASSES; r += 1){
+			for(i32 i = 0; i < BENCH_HULL_COUNT; i += 1){
+				i32 hull = (i32)(((u32)i * 2654435761u) & (BENCH_HULL_COUNT - 1));
+				Vector3 dir = bench_c[(i + r) & (BENCH_COUNT - 1)];
+				acc += gjk_polygon_support_index(&set[hull], dir);
+			}
+		}
+		f64 elapsed = thread_time() - start;
+		f64 ns_per_query = 1.0e9 * elapsed / ((f64)BENCH_HULL_COUNT * (f64)BENCH_HULL_PASSES);
+		printf("  %-16s %8.3f ns/query (%d bytes/hull)\n",
+			k == 0 ? "support" : "support (u16)", ns_per_query,
+			k == 0 ? (i32)(sizeof(Vector3) * BENCH_HULL_POINTS) : (i32)quantized_stride);
+		bench_sink += (f32)acc;
+	}
+
+	free(points);
+	free(quantized);
+	free(polygons);
+	free(qpolygons);
+}
+
+// ----------------------------------------------------------------
+// Mesh Build
+// ----------------------------------------------------------------
+// NOTE: A bumpy grid with about a million triangles.
+#define BENCH_MESH_SIDE 708
+
+static
+void bench_mesh_build(void){
+	i32 num_vertices = BENCH_MESH_SIDE * BENCH_MESH_SIDE;
+	i32 num_cells = (BENCH_MESH_SIDE - 1) * (BENCH_MESH_SIDE - 1);
+	i32 num_triangles = num_cells * 2;
+	Vector3 *vertices = (Vector3*)malloc(sizeof(Vector3) * num_vertices);
+	u32 *indices = (u32*)malloc(sizeof(u32) * 3 * num_triangles);
+	ASSERT(vertices != NULL && indices != NULL);
+	for(i32 row = 0; row < BENCH_MESH_SIDE; row += 1)
+	for(i32 col = 0; col < BENCH_MESH_SIDE; col += 1){
+		f32 height = 0.5f * bench_random();
+		vertices[row * BENCH_MESH_SIDE + col] = make_v3((f32)col, height, (f32)row);
+	}
+
+	u32 *index = indices;
+	for(i32 row = 0; row < (BENCH_MESH_SIDE - 1); row += 1)
+	for(i32 col = 0; col < (BENCH_MESH_SIDE - 1); col += 1){
+		u32 v00 = (u32)(row * BENCH_MESH_SIDE + col);
+		u32 v01 = v00 + BENCH_MESH_SIDE;
+		*index++ = v00; *index++ = v01 + 1; *index++ = v00 + 1;
+		*index++ = v00; *index++ = v01; *index++ = v01 + 1;
+	}
+
+	i32 max_threads = thread_hardware_concurrency();
+	for(i32 num_threads = 1; num_threads <= max_threads; num_threads *= 2){
+		f64 start = thread_time();
+		GJK_Mesh mesh = gjk_mesh_create(vertices, num_vertices,
+			indices, num_triangles, num_threads);
+		f64 elapsed = thread_time() - start;
+		f64 ms_per_million = 1.0e3 * elapsed * 1.0e6 / (f64)num_triangles;
+		printf("  mesh build (%2d threads) %8.3f ms/Mtri\n", num_threads, ms_per_million);
+		bench_sink += (f32)mesh.nodes[mesh.num_nodes - 1].qmax[0];
+		gjk_mesh_free(&mesh);
+	}
+
+	free(vertices);
+	free(indices);
+}
+
+// ----------------------------------------------------------------
+// World Step
+// ----------------------------------------------------------------
+// NOTE: Random boxes in a cube sized so that each one touches a few
+// others. Each step moves every body so the bounds and the broadphase
+// are redone too.
+#define BENCH_WORLD_BODIES 16384
+#define BENCH_WORLD_STEPS 16
+
+static
+void bench_world_step(void){
+	Vector3 box[8];
+	for(i32 i = 0; i < 8; i += 1){
+		box[i] = make_v3(
+			(i & 1) ? 0.5f : -0.5f,
+			(i & 2) ? 0.5f : -0.5f,
+			(i & 4) ? 0.5f : -0.5f);
+	}
+	GJK_Polygon local = make_gjk_polygon(box, 8);
+
+	Transform *transforms = (Transform*)malloc(sizeof(Transform)
+		* BENCH_WORLD_BODIES * BENCH_WORLD_STEPS);
+	ASSERT(transforms != NULL);
+	f32 extent = 2.0f * (f32)pow((f64)BENCH_WORLD_BODIES, 1.0 / 3.0);
+	for(i32 i = 0; i < (BENCH_WORLD_BODIES * BENCH_WORLD_STEPS); i += 1){
+		Quaternion q = quat_angle_axis(
+			(f32)CONST_PI * bench_random(),
+			bench_random_v3() + make_v3(0.0f, 0.0f, 2.0f));
+		transforms[i] = make_transform(q, 0.5f * extent * bench_random_v3());
+	}
+
+	i32 max_threads = thread_hardware_concurrency();
+	for(i32 num_threads = 1; num_threads <= max_threads; num_threads *= 2){
+		JobSystem *jobs = job_system_create(num_threads);
+		GJK_World world = gjk_world_create(BENCH_WORLD_BODIES, 0.05f);
+		for(i32 i = 0; i < BENCH_WORLD_BODIES; i += 1)
+			gjk_world_add_body(&world, &local, transforms[i]);
+
+		// NOTE: Warm up so the pair buffers and the pair cache are sized.
+		gjk_world_step(&world, jobs);
+
+		i32 num_contacts = 0;
+		f64 start = thread_time();
+		for(i32 step = 0; step < BENCH_WORLD_STEPS; step += 1){
+			Transform *step_transforms = &transforms[step * BENCH_WORLD_BODIES];
+			for(i32 i = 0; i < BENCH_WORLD_BODIES; i += 1)
+				gjk_world_set_transform(&world, i, step_transforms[i]);
+			gjk_world_step(&world, jobs);
+			num_contacts += world.num_contacts;
+		}
+		f64 elapsed = thread_time() - start;
+		printf("  world step (%2d threads) %8.3f ms/step (%d contacts/step)\n",
+			num_threads, 1.0e3 * elapsed / (f64)BENCH_WORLD_STEPS,
+			num_contacts / BENCH_WORLD_STEPS);
+		bench_sink += (f32)num_contacts;
+
+		gjk_world_free(&world);
+		job_system_destroy(jobs);
+	}
+
+	free(transforms);
+}
+
+// ----------------------------------------------------------------
+// MAIN
+// ----------------------------------------------------------------
+
+int main(int argc, char **argv){
+	static_assert(IS_POWER_OF_TWO(BENCH_COUNT), "");
+#if MATH_SIMD
+	printf("math backend: SIMD (sizeof(Vector3) = %d)\n", (i32)sizeof(Vector3));
+#else
+	printf("math backend: scalar (sizeof(Vector3) = %d)\n", (i32)sizeof(Vector3));
+#endif
+
+	bench_init();
+	bench_v3_dot();
+	bench_v3_cross();
+	bench_v3_triple_cross();
+	bench_v3_normalize();
+	bench_v3_rotate();
+	bench_mat4_mul();
+	bench_mat4_transform();
+	bench_transform_points();
+	bench_transform_points_soa();
+	bench_hull_support();
+	bench_mesh_build();
+	bench_world_step();
+
+	printf("(sink = %g)\n", bench_sink);
+	return 0;
+}
@@ -4,13 +4,19 @@ if [%SDL_PATH%]==[] @SET SDL_PATH="X:/libs/SDL/2.0.14"
 @SET CFLAGS=-W3 -WX -MTd -Zi -D_CRT_SECURE_NO_WARNINGS=1 -DBUILD_DEBUG=1 -I%SDL_PATH%/include
 @SET LFLAGS=-subsystem:console -incremental:no -opt:ref -dynamicbase
 @SET LLIBS=shell32.lib %SDL_PATH%/lib/x64/SDL2.lib %SDL_PATH%/lib/x64/SDL2main.lib
-@SET SRC="../gjk.cc" "../gjk_collision_test.cc" "../main.cc"
+@SET SRC="../gjk.cc" "../gjk_collision_test.cc" "../gjk_bounds.cc" "../gjk_pair_cache.cc" "../gjk_manifold.cc" "../gjk_bvh.cc" "../gjk_compound.cc" "../gjk_mesh.cc" "../gjk_hull.cc" "../gjk_asset.cc" "../jobs.cc" "../gjk_world.cc" "../gjk_frustum.cc" "../thread.cc" "../main.cc"
+@SET BENCH_CFLAGS=-W3 -WX -O2 -MT -D_CRT_SECURE_NO_WARNINGS=1
+@SET BENCH_SRC="../bench.cc" "../gjk.cc" "../gjk_bounds.cc" "../gjk_mesh.cc" "../gjk_pair_cache.cc" "../gjk_manifold.cc" "../jobs.cc" "../gjk_world.cc" "../thread.cc"
+@SET COOK_SRC="../cook.cc" "../gjk.cc" "../gjk_bounds.cc" "../gjk_hull.cc" "../gjk_mesh.cc" "../gjk_asset.cc" "../thread.cc"
 
 pushd %~dp0
 del /q .\build\*
 mkdir .\build
 pushd .\build
 cl %1 -Fe:"gjk.exe" %CFLAGS%  %SRC% /link %LFLAGS% %LLIBS%
+cl %1 -Fe:"bench.exe" %BENCH_CFLAGS% %BENCH_SRC% /link %LFLAGS%
+cl %1 -Fe:"bench_simd.exe" %BENCH_CFLAGS% -DMATH_SIMD=1 %BENCH_SRC% /link %LFLAGS%
+cl %1 -Fe:"cook.exe" %BENCH_CFLAGS% %COOK_SRC% /link %LFLAGS%
 popd
 popd
 
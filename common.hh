@@ -5,7 +5,9 @@
 static_assert(sizeof(void*) == 8, "");
 
 // stdlib base
+#include <float.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,10 +41,96 @@ typedef double		f64;
 // compiler settings
 #if defined(_MSC_VER)
 #	define INLINE __forceinline
+#	define THREAD_LOCAL __declspec(thread)
 #elif defined(__GNUC__)
 #	define INLINE __attribute__((always_inline)) inline
+#	define THREAD_LOCAL __thread
 #else
 #	define INLINE inline
+#	define THREAD_LOCAL thread_local
+#endif
+
+// atomics
+//	NOTE: These are only the operations we need. Loads have acquire
+// and stores have release semantics. Read-modify-write operations
+// are sequentially consistent.
+#if defined(_MSC_VER)
+#	include <intrin.h>
+static INLINE u64 atomic_load_u64(volatile u64 *ptr){
+	u64 result = *ptr;
+	_ReadWriteBarrier();
+	return result;
+}
+static INLINE void atomic_store_u64(volatile u64 *ptr, u64 value){
+	_ReadWriteBarrier();
+	*ptr = value;
+}
+// NOTE: Returns the value that was in `ptr` before the operation.
+static INLINE u64 atomic_cas_u64(volatile u64 *ptr, u64 expected, u64 desired){
+	return (u64)_InterlockedCompareExchange64(
+		(volatile long long*)ptr, (long long)desired, (long long)expected);
+}
+static INLINE u32 atomic_add_u32(volatile u32 *ptr, u32 value){
+	return (u32)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+}
+static INLINE u32 atomic_load_u32(volatile u32 *ptr){
+	u32 result = *ptr;
+	_ReadWriteBarrier();
+	return result;
+}
+static INLINE void atomic_store_u32(volatile u32 *ptr, u32 value){
+	_ReadWriteBarrier();
+	*ptr = value;
+}
+static INLINE u32 atomic_cas_u32(volatile u32 *ptr, u32 expected, u32 desired){
+	return (u32)_InterlockedCompareExchange(
+		(volatile long*)ptr, (long)desired, (long)expected);
+}
+static INLINE u32 atomic_exchange_u32(volatile u32 *ptr, u32 value){
+	return (u32)_InterlockedExchange((volatile long*)ptr, (long)value);
+}
+static INLINE void cpu_pause(void){
+	_mm_pause();
+}
+#elif defined(__GNUC__)
+static INLINE u64 atomic_load_u64(volatile u64 *ptr){
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+static INLINE void atomic_store_u64(volatile u64 *ptr, u64 value){
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+// NOTE: Returns the value that was in `ptr` before the operation.
+static INLINE u64 atomic_cas_u64(volatile u64 *ptr, u64 expected, u64 desired){
+	__atomic_compare_exchange_n(ptr, &expected, desired,
+		false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return expected;
+}
+static INLINE u32 atomic_add_u32(volatile u32 *ptr, u32 value){
+	return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+static INLINE u32 atomic_load_u32(volatile u32 *ptr){
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+static INLINE void atomic_store_u32(volatile u32 *ptr, u32 value){
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+static INLINE u32 atomic_cas_u32(volatile u32 *ptr, u32 expected, u32 desired){
+	__atomic_compare_exchange_n(ptr, &expected, desired,
+		false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return expected;
+}
+static INLINE u32 atomic_exchange_u32(volatile u32 *ptr, u32 value){
+	return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+static INLINE void cpu_pause(void){
+#	if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#	else
+	__asm__ __volatile__("" ::: "memory");
+#	endif
+}
+#else
+#	error "atomics not implemented for this compiler"
 #endif
 
 // common macros
@@ -0,0 +1,272 @@
+// NOTE: Offline cooking tool. Reads a Wavefront OBJ and writes a cooked
+// asset (see gjk_asset.hh) with either one convex hull or one triangle
+// mesh per object. It doesn't depend on SDL.
+//
+//	cook [-mesh] input.obj output.gjka
+//
+// Only `v`, `f`, `o` and `g` lines are used. Faces with more than three
+// vertices are triangulated as a fan.
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk_asset.hh"
+#include "gjk_hull.hh"
+#include "gjk_mesh.hh"
+#include "thread.hh"
+
+// ----------------------------------------------------------------
+// OBJ
+// ----------------------------------------------------------------
+struct CookObject{
+	i32 first_index;
+	i32 num_indices;
+};
+
+struct CookScene{
+	i32 num_vertices;
+	i32 max_vertices;
+	Vector3 *vertices;
+
+	i32 num_indices;
+	i32 max_indices;
+	u32 *indices;
+
+	i32 num_objects;
+	i32 max_objects;
+	CookObject *objects;
+};
+
+#define COOK_PUSH(array, count, capacity, value)							\
+	do{																		\
+		if((count) == (capacity)){											\
+			(capacity) = (capacity) > 0 ? (capacity) * 2 : 256;				\
+			(array) = (decltype(array))realloc((array), sizeof(*(array)) * (capacity));\
+			ASSERT((array) != NULL);										\
+		}																	\
+		(array)[(count)] = (value);											\
+		(count) += 1;														\
+	}while(0)
+
+static
+void cook_begin_object(CookScene *scene){
+	CookObject *last = scene->num_objects > 0
+		? &scene->objects[scene->num_objects - 1] : NULL;
+	if(last != NULL && last->num_indices == 0)
+		return;
+
+	CookObject object = {};
+	object.first_index = scene->num_indices;
+	COOK_PUSH(scene->objects, scene->num_objects, scene->max_objects, object);
+}
+
+// NOTE: Parses the vertex index of a face element ("i", "i/t", "i//n"
+// or "i/t/n"). Negative indices are relative to the end of the vertex
+// list. Returns false on failure.
+static
+bool cook_parse_index(char **cursor, i32 num_vertices, u32 *out){
+	char *end;
+	long index = strtol(*cursor, &end, 10);
+	if(end == *cursor)
+		return false;
+	while(*end != 0 && *end != ' ' && *end != '\t' && *end != '\r' && *end != '\n')
+		end += 1;
+	*cursor = end;
+
+	if(index < 0)
+		index = (long)num_vertices + index;
+	else
+		index -= 1;
+	if(index < 0 || index >= (long)num_vertices)
+		return false;
+	*out = (u32)index;
+	return true;
+}
+
+static
+bool cook_load_obj(const char *filename, CookScene *scene){
+	FILE *file = fopen(filename, "rb");
+	if(file == NULL){
+		LOG_ERROR("failed to open \"%s\"\n", filename);
+		return false;
+	}
+
+	memset(scene, 0, sizeof(CookScene));
+	cook_begin_object(scene);
+
+	char line[1024];
+	i32 line_number = 0;
+	bool result = true;
+	while(result && fgets(line, sizeof(line), file) != NULL){
+		line_number += 1;
+		char *cursor = line;
+		while(*cursor == ' ' || *cursor == '\t')
+			cursor += 1;
+
+		if(cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')){
+			f32 x, y, z;
+			if(sscanf(cursor + 2, "%f %f %f", &x, &y, &z) != 3){
+				result = false;
+				break;
+			}
+			COOK_PUSH(scene->vertices, scene->num_vertices,
+				scene->max_vertices, make_v3(x, y, z));
+		}else if(cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')){
+			u32 face[64];
+			i32 num_face = 0;
+			cursor += 2;
+			while(true){
+				while(*cursor == ' ' || *cursor == '\t')
+					cursor += 1;
+				if(*cursor == 0 || *cursor == '\r' || *cursor == '\n')
+					break;
+				if(num_face == (i32)NARRAY(face)
+				|| !cook_parse_index(&cursor, scene->num_vertices, &face[num_face])){
+					result = false;
+					break;
+				}
+				num_face += 1;
+			}
+			if(result && num_face < 3)
+				result = false;
+
+			CookObject *object = &scene->objects[scene->num_objects - 1];
+			for(i32 i = 2; result && i < num_face; i += 1){
+				COOK_PUSH(scene->indices, scene->num_indices, scene->max_indices, face[0]);
+				COOK_PUSH(scene->indices, scene->num_indices, scene->max_indices, face[i - 1]);
+				COOK_PUSH(scene->indices, scene->num_indices, scene->max_indices, face[i]);
+				object->num_indices += 3;
+			}
+		}else if((cursor[0] == 'o' || cursor[0] == 'g')
+				&& (cursor[1] == ' ' || cursor[1] == '\t' || cursor[1] == '\r' || cursor[1] == '\n')){
+			cook_begin_object(scene);
+		}
+	}
+	fclose(file);
+
+	if(!result){
+		LOG_ERROR("%s:%d: invalid line\n", filename, line_number);
+		return false;
+	}
+
+	// NOTE: Drop the trailing object if it has no faces.
+	if(scene->objects[scene->num_objects - 1].num_indices == 0)
+		scene->num_objects -= 1;
+	return true;
+}
+
+static
+void cook_free_scene(CookScene *scene){
+	free(scene->vertices);
+	free(scene->indices);
+	free(scene->objects);
+	memset(scene, 0, sizeof(CookScene));
+}
+
+// ----------------------------------------------------------------
+// Main
+// ----------------------------------------------------------------
+int main(int argc, char **argv){
+	bool cook_meshes = false;
+	const char *input = NULL;
+	const char *output = NULL;
+	for(i32 i = 1; i < argc; i += 1){
+		if(strcmp(argv[i], "-mesh") == 0)
+			cook_meshes = true;
+		else if(input == NULL)
+			input = argv[i];
+		else if(output == NULL)
+			output = argv[i];
+		else
+			input = output = NULL;
+	}
+
+	if(input == NULL || output == NULL){
+		fprintf(stdout, "usage: cook [-mesh] input.obj output.gjka\n");
+		return 1;
+	}
+
+	CookScene scene;
+	if(!cook_load_obj(input, &scene))
+		return 1;
+
+	// NOTE: Objects reference the shared vertex list so each one gets its
+	// own compacted copy to keep the cooked shapes independent.
+	i32 num_objects = scene.num_objects;
+	Vector3 **object_vertices = (Vector3**)calloc(num_objects + 1, sizeof(Vector3*));
+	i32 *object_num_vertices = (i32*)calloc(num_objects + 1, sizeof(i32));
+	u32 **object_indices = (u32**)calloc(num_objects + 1, sizeof(u32*));
+	i32 *remap = (i32*)malloc(sizeof(i32) * (scene.num_vertices + 1));
+	ASSERT(object_vertices != NULL && object_num_vertices != NULL
+		&& object_indices != NULL && remap != NULL);
+	for(i32 i = 0; i < num_objects; i += 1){
+		CookObject *object = &scene.objects[i];
+		for(i32 j = 0; j < scene.num_vertices; j += 1)
+			remap[j] = -1;
+
+		Vector3 *vertices = (Vector3*)malloc(sizeof(Vector3) * object->num_indices);
+		u32 *indices = (u32*)malloc(sizeof(u32) * object->num_indices);
+		ASSERT(vertices != NULL && indices != NULL);
+		i32 num_vertices = 0;
+		for(i32 j = 0; j < object->num_indices; j += 1){
+			u32 vertex = scene.indices[object->first_index + j];
+			if(remap[vertex] < 0){
+				remap[vertex] = num_vertices;
+				vertices[num_vertices] = scene.vertices[vertex];
+				num_vertices += 1;
+			}
+			indices[j] = (u32)remap[vertex];
+		}
+		object_vertices[i] = vertices;
+		object_num_vertices[i] = num_vertices;
+		object_indices[i] = indices;
+	}
+
+	bool result = true;
+	if(cook_meshes){
+		i32 num_threads = thread_hardware_concurrency();
+		GJK_Mesh *meshes = (GJK_Mesh*)calloc(num_objects + 1, sizeof(GJK_Mesh));
+		ASSERT(meshes != NULL);
+		for(i32 i = 0; i < num_objects; i += 1){
+			meshes[i] = gjk_mesh_create(object_vertices[i], object_num_vertices[i],
+				object_indices[i], scene.objects[i].num_indices / 3, num_threads);
+		}
+		result = gjk_asset_write(output, NULL, NULL, 0, meshes, num_objects);
+		for(i32 i = 0; i < num_objects; i += 1)
+			gjk_mesh_free(&meshes[i]);
+		free(meshes);
+	}else{
+		GJK_Hull *hulls = (GJK_Hull*)calloc(num_objects + 1, sizeof(GJK_Hull));
+		u32 *hull_ids = (u32*)calloc(num_objects + 1, sizeof(u32));
+		ASSERT(hulls != NULL && hull_ids != NULL);
+		i32 num_hulls = 0;
+		for(i32 i = 0; i < num_objects; i += 1){
+			if(!gjk_hull_build(object_vertices[i], object_num_vertices[i], &hulls[num_hulls])){
+				LOG_ERROR("object %d is degenerate, skipping\n", i);
+				continue;
+			}
+			hull_ids[num_hulls] = (u32)i;
+			num_hulls += 1;
+		}
+		result = gjk_asset_write(output, hulls, hull_ids, num_hulls, NULL, 0);
+		for(i32 i = 0; i < num_hulls; i += 1)
+			gjk_hull_free(&hulls[i]);
+		free(hull_ids);
+		free(hulls);
+	}
+
+	if(result){
+		fprintf(stdout, "cooked %d %s from \"%s\" into \"%s\"\n", num_objects,
+			cook_meshes ? "meshes" : "objects", input, output);
+	}
+
+	for(i32 i = 0; i < num_objects; i += 1){
+		free(object_vertices[i]);
+		free(object_indices[i]);
+	}
+	free(object_vertices);
+	free(object_num_vertices);
+	free(object_indices);
+	free(remap);
+	cook_free_scene(&scene);
+	return result ? 0 : 1;
+}
@@ -1,9 +1,11 @@
 // NOTE(IMPORTANT): Different from gjk_collision_test, our main
 // condition to leave the iteration loop is when no progress has
 // been made (ie. the support function returned a point that was
-// already in the simplex it returned a point that made the next
-// simplex degenerate). Because of that, we need to check extra
-// cases when the origin could be behind the point A.
+// already in the simplex, a point that isn't any closer to the
+// origin, or a point that made the next simplex degenerate).
+// Because of that, the origin may not be past the point A and the
+// simplex reductions need to find the closest feature exactly
+// instead of only looking at the features around A.
 
 #include "gjk.hh"
 
@@ -11,6 +13,13 @@ struct GJK_Point{
 	Vector3 minkowski;
 	Vector3 polygon1;
 	Vector3 polygon2;
+
+	// NOTE: Indices of the support points in their polygons and the
+	// support direction. We need these to recompute the final result
+	// in f64.
+	i32 index1;
+	i32 index2;
+	Vector3 dir;
 };
 
 static bool gjk_check_degenerate_simplex2(GJK_Point *points, i32 num_points){
@@ -20,13 +29,22 @@ static bool gjk_check_degenerate_simplex2(GJK_Point *points, i32 num_points){
 	return v3_cmp_zero(B - A);
 }
 
+// NOTE: Triangles and tetrahedrons are degenerate when they are flat
+// relative to their own size (the sine of the angle between the new
+// edge and the rest of the simplex is tiny). An absolute area or volume
+// threshold would throw away valid simplices of small shapes and
+// keep flat ones of large shapes.
+#define GJK_DEGENERATE_TOLERANCE 1.0e-4f
+
 static bool gjk_check_degenerate_simplex3(GJK_Point *points, i32 num_points){
 	ASSERT(num_points == 3);
 	Vector3 A = points[2].minkowski;
 	Vector3 B = points[1].minkowski;
 	Vector3 C = points[0].minkowski;
-	f32 area = 0.5f * v3_norm(v3_cross(B - A, C - A));
-	return f32_cmp_zero(area);
+	Vector3 AB = B - A;
+	Vector3 AC = C - A;
+	f32 area = v3_norm(v3_cross(AB, AC));
+	return area <= GJK_DEGENERATE_TOLERANCE * v3_norm(AB) * v3_norm(AC);
 }
 
 static bool gjk_check_degenerate_simplex4(GJK_Point *points, i32 num_points){
@@ -35,9 +53,10 @@ static bool gjk_check_degenerate_simplex4(GJK_Point *points, i32 num_points){
 	Vector3 B = points[2].minkowski;
 	Vector3 C = points[1].minkowski;
 	Vector3 D = points[0].minkowski;
-	//f32 volume = 0.1666667f * v3_dot(v3_cross(C - A, B - A), D - A);
-	f32 volume = (1.0f / 6.0f) * v3_dot(v3_cross(C - A, B - A), D - A);
-	return f32_cmp_zero(volume);
+	Vector3 normal = v3_cross(C - A, B - A);
+	Vector3 AD = D - A;
+	f32 volume = f32_abs(v3_dot(normal, AD));
+	return volume <= GJK_DEGENERATE_TOLERANCE * v3_norm(normal) * v3_norm(AD);
 }
 
 static bool gjk_check_degenerate_simplex(GJK_Point *points, i32 num_points){
@@ -69,53 +88,90 @@ void gjk_simplex2(GJK_Point *points, i32 *num_points, Vector3 *dir){
 	}
 }
 
+// NOTE: Reduces the triangle to the feature closest to the origin and
+// returns the closest point. If it's the face, it's wound so `dir` is
+// its normal on the side of the origin. Unlike the overlap test (see
+// `gjk_collision_test`), every feature is tested here, otherwise the
+// loop could drop to a feature that isn't the closest one and cycle
+// until it runs out of iterations.
 static
-void gjk_simplex3(GJK_Point *points, i32 *num_points, Vector3 *dir){
+Vector3 gjk_simplex3_reduce(GJK_Point *points, i32 *num_points, Vector3 *dir){
 	// A = points[2].minkowski
 	// B = points[1].minkowski
 	// C = points[0].minkowski
 	ASSERT(*num_points == 3);
-	Vector3 AO = -points[2].minkowski;
-	Vector3 AB = points[1].minkowski - points[2].minkowski;
-	Vector3 AC = points[0].minkowski - points[2].minkowski;
-	Vector3 ABC = v3_cross(AB, AC);
-	Vector3 aux;
-
-	aux = v3_cross(ABC, AC);
-	if(v3_dot(aux, AO) > 0){
-		if(v3_dot(AC, AO) > 0){
-			// points = [C, A], dir = AC x AO x AC
-			//points[0] = points[0];
-			points[1] = points[2];
-			*num_points = 2;
-			*dir = v3_triple_cross(AC, AO, AC);
-		}else{
-			// points = [A], dir = AO
-			points[0] = points[2];
-			*num_points = 1;
-			*dir = AO;
-		}
-		return;
+	Vector3 A = points[2].minkowski;
+	Vector3 B = points[1].minkowski;
+	Vector3 C = points[0].minkowski;
+	Vector3 AB = B - A;
+	Vector3 AC = C - A;
+
+	// NOTE: Voronoi regions of the triangle in the same order as in
+	// Ericson's "Real-Time Collision Detection" (5.1.5).
+	f32 d1 = v3_dot(AB, -A);
+	f32 d2 = v3_dot(AC, -A);
+	if(d1 <= 0 && d2 <= 0){
+		// points = [A], dir = AO
+		points[0] = points[2];
+		*num_points = 1;
+		*dir = -A;
+		return A;
 	}
 
-	aux = v3_cross(AB, ABC);
-	if(v3_dot(aux, AO) > 0){
-		if(v3_dot(AB, AO) > 0){
-			// points = [B, A], dir = AB x AO x AB
-			points[0] = points[1];
-			points[1] = points[2];
-			*num_points = 2;
-			*dir = v3_triple_cross(AB, AO, AB);
-		}else{
-			// points = [A], dir = AO
-			points[0] = points[2];
-			*num_points = 1;
-			*dir = AO;
-		}
-		return;
+	f32 d3 = v3_dot(AB, -B);
+	f32 d4 = v3_dot(AC, -B);
+	if(d3 >= 0 && d4 <= d3){
+		// points = [B], dir = BO
+		points[0] = points[1];
+		*num_points = 1;
+		*dir = -B;
+		return B;
+	}
+
+	f32 vc = d1 * d4 - d3 * d2;
+	if(vc <= 0 && d1 >= 0 && d3 <= 0){
+		// points = [B, A], dir = AB x AO x AB
+		points[0] = points[1];
+		points[1] = points[2];
+		*num_points = 2;
+		*dir = v3_triple_cross(AB, -A, AB);
+		return A + (d1 / (d1 - d3)) * AB;
 	}
 
-	if(v3_dot(ABC, AO) > 0){
+	f32 d5 = v3_dot(AB, -C);
+	f32 d6 = v3_dot(AC, -C);
+	if(d6 >= 0 && d5 <= d6){
+		// points = [C], dir = CO
+		//points[0] = points[0];
+		*num_points = 1;
+		*dir = -C;
+		return C;
+	}
+
+	f32 vb = d5 * d2 - d1 * d6;
+	if(vb <= 0 && d2 >= 0 && d6 <= 0){
+		// points = [C, A], dir = AC x AO x AC
+		//points[0] = points[0];
+		points[1] = points[2];
+		*num_points = 2;
+		*dir = v3_triple_cross(AC, -A, AC);
+		return A + (d2 / (d2 - d6)) * AC;
+	}
+
+	f32 va = d3 * d6 - d5 * d4;
+	if(va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0){
+		// points = [C, B], dir = BC x BO x BC
+		Vector3 BC = C - B;
+		//points[0] = points[0];
+		//points[1] = points[1];
+		*num_points = 2;
+		*dir = v3_triple_cross(BC, -B, BC);
+		return B + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * BC;
+	}
+
+	Vector3 ABC = v3_cross(AB, AC);
+	f32 abc_ao = v3_dot(ABC, -A);
+	if(abc_ao > 0){
 		// points = [C, B, A], dir = ABC
 		*dir = ABC;
 	}else{
@@ -125,6 +181,7 @@ void gjk_simplex3(GJK_Point *points, i32 *num_points, Vector3 *dir){
 		points[1] = tmp;
 		*dir = -ABC;
 	}
+	return (-abc_ao / v3_dot(ABC, ABC)) * ABC;
 }
 
 static
@@ -134,117 +191,65 @@ bool gjk_simplex4(GJK_Point *points, i32 *num_points, Vector3 *dir){
 	// C = points[1].minkowski
 	// D = points[0].minkowski
 	ASSERT(*num_points == 4);
-	Vector3 AO = -points[3].minkowski;
-	Vector3 AB = points[2].minkowski - points[3].minkowski;
-	Vector3 AC = points[1].minkowski - points[3].minkowski;
-	Vector3 AD = points[0].minkowski - points[3].minkowski;
-	Vector3 ACB = v3_cross(AB, AC);
-	Vector3 ABD = v3_cross(AD, AB);
-	Vector3 ADC = v3_cross(AC, AD);
-
-	// NOTE: In the case we return a triangle as the next simplex
-	// the winding order of that which will become an INNER face
-	// of the tetrahedron must be clockwise. This means that the
-	// same triangle OUTTER face will have with a counter-clockwise
-	// winding order.
-
-	// TODO: I've fixed the winding order of the triangles we
-	// return but if we ever get any unexpected result, we should
-	// check if there aren't any errors there. It's easy to lose
-	// track of these details.
-
-	// TODO: The DEBUG_ASSERT when handling the ABD triangle was
-	// triggering because either AB or AD dot product with AO was
-	// slightly negative. This seemed to happen whenever the origin
-	// was very close to one of the edges. I then changed the assertion
-	// to require only one of the dot products to be positive but i'm
-	// not sure if we still have a bug.
-
-	if(v3_dot(ACB, AO) > 0){
-		if(v3_dot(ABD, AO) > 0){
-			if(v3_dot(AB, AO) > 0){
-				// points = [B, A], dir = AB x AO x AB
-				points[0] = points[2];
-				points[1] = points[3];
-				*num_points = 2;
-				*dir = v3_triple_cross(AB, AO, AB);
-			}else{
-				// points = [A], dir = AO
-				points[0] = points[3];
-				*num_points = 1;
-				*dir = AO;
-			}
-		}else if(v3_dot(ADC, AO) > 0){
-			if(v3_dot(AC, AO) > 0){
-				// points = [C, A], dir = AC x AO x AC
-				points[0] = points[1];
-				points[1] = points[3];
-				*num_points = 2;
-				*dir = v3_triple_cross(AC, AO, AC);
-			}else{
-				// points = [A], dir = AO
-				points[0] = points[3];
-				*num_points = 1;
-				*dir = AO;
-			}
-		}else{
-			ASSERT(v3_dot(AB, AO) > 0 || v3_dot(AC, AO) > 0);
-			// points = [C, B, A], dir = ACB
-			points[0] = points[1];
-			points[1] = points[2];
-			points[2] = points[3];
-			*num_points = 3;
-			*dir = ACB;
-		}
 
-		return false;
-	}
+	// NOTE: The faces that contain A as [opposite, triangle]. The
+	// triangles are in the [C, B, A] order of `gjk_simplex3_reduce`.
+	// The face opposite to A is never the closest one since A was
+	// found past it in the direction of the origin.
+	static const i32 faces[3][4] = {
+		{ 0, 1, 2, 3 },		// ACB, opposite D
+		{ 1, 0, 2, 3 },		// ABD, opposite C
+		{ 2, 0, 1, 3 },		// ADC, opposite B
+	};
 
-	if(v3_dot(ABD, AO) > 0){
-		// NOTE: The case (ABD && ACB) is already covered in the
-		// tests above.
-		if(v3_dot(ADC, AO) > 0){
-			if(v3_dot(AD, AO) > 0){
-				// points = [D, A], dir = AD x AO x AD
-				//points[0] = points[0];
-				points[1] = points[3];
-				*num_points = 2;
-				*dir = v3_triple_cross(AD, AO, AD);
-			}else{
-				// points = [A], dir = AO
-				points[0] = points[3];
-				*num_points = 1;
-				*dir = AO;
-			}
-		}else{
-			ASSERT(v3_dot(AB, AO) > 0 || v3_dot(AD, AO) > 0);
-			// points = [B, D, A], dir = ABD
-			GJK_Point tmp = points[0];
-			points[0] = points[2];
-			points[1] = tmp;
-			points[2] = points[3];
-			*num_points = 3;
-			*dir = ABD;
+	Vector3 A = points[3].minkowski;
+	Vector3 AO = -A;
+	GJK_Point best[3];
+	i32 best_num_points = 0;
+	Vector3 best_dir = v3_zero;
+	f32 best_distance2 = FLT_MAX;
+	for(i32 i = 0; i < 3; i += 1){
+		const i32 *face = faces[i];
+		Vector3 AP = points[face[1]].minkowski - A;
+		Vector3 AQ = points[face[2]].minkowski - A;
+		Vector3 normal = v3_cross(AP, AQ);
+		if(v3_dot(normal, points[face[0]].minkowski - A) > 0)
+			normal = -normal;
+		if(v3_dot(normal, AO) <= 0)
+			continue;
+
+		// NOTE: The origin is outside this face so the closest point
+		// is on the boundary of the tetrahedron. It's on one of the
+		// faces the origin is outside of.
+		GJK_Point triangle[3] = {
+			points[face[1]],
+			points[face[2]],
+			points[face[3]],
+		};
+		i32 num_triangle_points = 3;
+		Vector3 triangle_dir;
+		Vector3 closest = gjk_simplex3_reduce(triangle,
+			&num_triangle_points, &triangle_dir);
+		f32 distance2 = v3_dot(closest, closest);
+		if(distance2 < best_distance2){
+			for(i32 j = 0; j < num_triangle_points; j += 1)
+				best[j] = triangle[j];
+			best_num_points = num_triangle_points;
+			best_dir = triangle_dir;
+			best_distance2 = distance2;
 		}
-		return false;
 	}
 
-	if(v3_dot(ADC, AO) > 0){
-		// NOTE: The cases (ADC && ACB) and (ADC && ABD) are already
-		// covered in the tests above.
-		ASSERT(v3_dot(AC, AO) > 0 || v3_dot(AD, AO) > 0);
-		// points = [D, C, A], dir = ADC
-		//points[0] = points[0];
-		//points[1] = points[1];
-		points[2] = points[3];
-		*num_points = 3;
-		*dir = ADC;
-		return false;
-	}
+	// NOTE: If we get here with no face, the tetrahedron contains
+	// the origin which means the shapes are overlapping.
+	if(best_num_points == 0)
+		return true;
 
-	// NOTE: If we get here, the tetrahedron contains the
-	// origin which means the shapes are overlapping.
-	return true;
+	for(i32 i = 0; i < best_num_points; i += 1)
+		points[i] = best[i];
+	*num_points = best_num_points;
+	*dir = best_dir;
+	return false;
 }
 
 static INLINE
@@ -263,7 +268,11 @@ f32 gjk_distance2(GJK_Point A, GJK_Point B,
 	Vector3 AO = -A.minkowski;
 	Vector3 AB = B.minkowski - A.minkowski;
 	f32 k = v3_dot(AO, AB) / v3_norm2(AB);
-	ASSERT(k >= 0.0f && k <= 1.0f);
+	// NOTE: Segments whose closest point is at one end are reported as
+	// a single point (see `gjk_no_overlap_result`) so `k` can only be
+	// outside [0, 1] by rounding.
+	if(k < 0.0f) k = 0.0f;
+	if(k > 1.0f) k = 1.0f;
 	Vector3 closest = A.minkowski + k * AB;
 	f32 distance = v3_norm(closest);
 	ASSERT(closest1 && closest2);
@@ -355,17 +364,33 @@ GJK_Result gjk_overlap_result(void){
 }
 
 static INLINE
-GJK_Result gjk_no_overlap_result(GJK_Point *points, i32 num_points){
+GJK_Result gjk_no_overlap_result(GJK_Point *points, i32 *num_points){
 	// TODO: In the case we get two parallel triangles, we may
 	// get some flickering because any line perpendicular to both
 	// can be used to calculate the closest points. Perhaps the
 	// best solution would be to let the gjk caller handle this
 	// case separately.
 
-	ASSERT(num_points >= 1 && num_points <= 3);
+	ASSERT(*num_points >= 1 && *num_points <= 3);
+
+	// NOTE: The reductions only keep a segment when the closest point
+	// is inside it but rounding may still put it at one end. Report
+	// that end alone so the closest features match the closest points.
+	// The simplex is reduced in place so callers see the same feature.
+	if(*num_points == 2){
+		Vector3 AB = points[0].minkowski - points[1].minkowski;
+		f32 k = v3_dot(-points[1].minkowski, AB) / v3_norm2(AB);
+		if(k <= 0.0f){
+			points[0] = points[1];
+			*num_points = 1;
+		}else if(k >= 1.0f){
+			*num_points = 1;
+		}
+	}
+
 	GJK_Result result;
 	result.overlap = false;
-	switch(num_points){
+	switch(*num_points){
 		case 1: {
 			result.distance = gjk_distance1(points[0],
 					&result.closest1, &result.closest2);
@@ -459,94 +484,304 @@ GJK_Result gjk_no_overlap_result(GJK_Point *points, i32 num_points){
 	return result;
 }
 
+i32 gjk_polygon_support_index(GJK_Polygon *p, Vector3 dir){
+	ASSERT(p->num_points > 0);
+	i32 index = 0;
+	if(p->quantized != NULL && p->indices == NULL){
+		// NOTE: dot(origin + scale * q, dir) = dot(origin, dir)
+		// + dot(q, scale * dir) and the first term is the same for
+		// every point.
+		const u16 *q = gjk_quantized_points(p->quantized);
+		Vector3 qdir = p->quantized->scale * dir;
+		f32 max = qdir.x * (f32)q[0] + qdir.y * (f32)q[1] + qdir.z * (f32)q[2];
+		for(i32 i = 1; i < p->num_points; i += 1){
+			q += 3;
+			f32 dot = qdir.x * (f32)q[0] + qdir.y * (f32)q[1] + qdir.z * (f32)q[2];
+			if(dot > max){
+				max = dot;
+				index = i;
+			}
+		}
+	}else if(gjk_polygon_is_packed(p)){
+		const Vector3 *points = p->points;
+		f32 max = v3_dot(points[0], dir);
+		for(i32 i = 1; i < p->num_points; i += 1){
+			f32 dot = v3_dot(points[i], dir);
+			if(dot > max){
+				max = dot;
+				index = i;
+			}
+		}
+	}else{
+		f32 max = v3_dot(gjk_polygon_point(p, 0), dir);
+		for(i32 i = 1; i < p->num_points; i += 1){
+			f32 dot = v3_dot(gjk_polygon_point(p, i), dir);
+			if(dot > max){
+				max = dot;
+				index = i;
+			}
+		}
+	}
+	return index;
+}
+
+// NOTE: Support point of `p` in direction `dir` for the vertex at
+// `index`, inflated if `p` is quantized.
+static INLINE
+Vector3 gjk_polygon_support_point(GJK_Polygon *p, i32 index, Vector3 dir){
+	return gjk_polygon_point(p, index) + gjk_polygon_inflation(p, dir);
+}
+
 static
 GJK_Point gjk_polygon_support(GJK_Polygon *p1, GJK_Polygon *p2, Vector3 dir){
 	ASSERT(p1->num_points > 0 && p2->num_points > 0);
+	i32 index1 = gjk_polygon_support_index(p1, dir);
+	i32 index2 = gjk_polygon_support_index(p2, -dir);
 
-	i32 index1 = 0;
-	f32 max1 = v3_dot(p1->points[0], dir);
-
-	i32 index2 = 0;
-	f32 max2 = v3_dot(p2->points[0], -dir);
-
-	i32 imax = i32_max(p1->num_points, p2->num_points);
-	for(i32 i = 1; i < imax; i += 1){
-		if(i < p1->num_points){
-			f32 dot = v3_dot(p1->points[i], dir);
-			if(dot > max1){
-				max1 = dot;
-				index1 = i;
-			}
-		}
+	GJK_Point result;
+	result.polygon1 = gjk_polygon_support_point(p1, index1, dir);
+	result.polygon2 = gjk_polygon_support_point(p2, index2, -dir);
+	result.minkowski = result.polygon1 - result.polygon2;
+	result.index1 = index1;
+	result.index2 = index2;
+	result.dir = dir;
+	return result;
+}
 
-		if(i < p2->num_points){
-			f32 dot = v3_dot(p2->points[i], -dir);
-			if(dot > max2){
-				max2 = dot;
-				index2 = i;
-			}
+// NOTE: Same as above but with every point taken relative to
+// `origin`. When both polygons are far from the world origin,
+// the dot products above are dominated by the magnitude of the
+// points and the support function can pick the wrong vertex.
+// Quantized points are already relative to their own bounds so
+// they don't need it.
+static INLINE
+i32 gjk_polygon_support_index_shifted(GJK_Polygon *p, Vector3 origin, Vector3 dir){
+	if(p->quantized != NULL)
+		return gjk_polygon_support_index(p, dir);
+
+	i32 index = 0;
+	f32 max = v3_dot(gjk_polygon_point(p, 0) - origin, dir);
+	for(i32 i = 1; i < p->num_points; i += 1){
+		f32 dot = v3_dot(gjk_polygon_point(p, i) - origin, dir);
+		if(dot > max){
+			max = dot;
+			index = i;
 		}
 	}
+	return index;
+}
+
+static
+GJK_Point gjk_polygon_support_shifted(GJK_Polygon *p1,
+		GJK_Polygon *p2, Vector3 origin, Vector3 dir){
+	ASSERT(p1->num_points > 0 && p2->num_points > 0);
+	i32 index1 = gjk_polygon_support_index_shifted(p1, origin, dir);
+	i32 index2 = gjk_polygon_support_index_shifted(p2, origin, -dir);
 
 	GJK_Point result;
-	result.minkowski = p1->points[index1] - p2->points[index2];
-	result.polygon1 = p1->points[index1];
-	result.polygon2 = p2->points[index2];
+	result.polygon1 = gjk_polygon_support_point(p1, index1, dir) - origin;
+	result.polygon2 = gjk_polygon_support_point(p2, index2, -dir) - origin;
+	result.minkowski = result.polygon1 - result.polygon2;
+	result.index1 = index1;
+	result.index2 = index2;
+	result.dir = dir;
 	return result;
 }
 
-GJK_Result gjk(GJK_Polygon *p1, GJK_Polygon *p2){
-	GJK_Point initial_point = gjk_polygon_support(
-			p1, p2, make_v3(0.0f, 0.0f, -1.0f));
+// NOTE: Smallest distance the new support point must move the simplex
+// towards the origin for the loop to go on.
+#define GJK_PROGRESS_TOLERANCE 1.0e-6f
+
+// NOTE: Runs the main loop and leaves the final simplex in `points`.
+// If `origin` is not NULL, all iterations are done relative to it.
+// Returns true if the polygons are overlapping.
+static
+bool gjk_iterate(GJK_Polygon *p1, GJK_Polygon *p2, Vector3 *origin,
+		GJK_Point *points, i32 *num_points){
+	Vector3 initial_dir = make_v3(0.0f, 0.0f, -1.0f);
+	GJK_Point initial_point = origin
+		? gjk_polygon_support_shifted(p1, p2, *origin, initial_dir)
+		: gjk_polygon_support(p1, p2, initial_dir);
 	Vector3 direction = -initial_point.minkowski;
-	i32 num_points = 1;
-	GJK_Point points[4] = { initial_point };
+	points[0] = initial_point;
+	*num_points = 1;
 
 	// NOTE: Without this check, when two exact polygons are
 	// overlapping exactly, we'll end up doing invalid work.
 	if(v3_cmp_zero(initial_point.minkowski))
-		return gjk_overlap_result();
+		return true;
 
 	for(i32 num_iter = 0; num_iter < 16; num_iter += 1){
-		GJK_Point next_point = gjk_polygon_support(p1, p2, direction);
+		GJK_Point next_point = origin
+			? gjk_polygon_support_shifted(p1, p2, *origin, direction)
+			: gjk_polygon_support(p1, p2, direction);
 		if(v3_cmp_zero(next_point.minkowski))
-			return gjk_overlap_result();
+			return true;
 
 		// TODO: We might get in trouble if we choose to use
 		// a smart support function here.
-		for(i32 i = 0; i < num_points; i += 1){
+		for(i32 i = 0; i < *num_points; i += 1){
 			if(next_point.minkowski == points[i].minkowski)
-				goto no_overlap_result;
+				return false;
 		}
 
-		points[num_points] = next_point;
-		num_points += 1;
+		// NOTE: Every point of the current simplex is at the same
+		// distance along `direction` (it's perpendicular to the closest
+		// feature). If the new point isn't any further along it, it can't
+		// bring the simplex closer to the origin. The reductions below
+		// only look at the features around the newest point, which is
+		// only right when it made progress, so keeping it would leave
+		// a simplex whose closest point may be on another feature.
+		f32 progress = v3_dot(next_point.minkowski
+			- points[*num_points - 1].minkowski, direction);
+		if(progress <= GJK_PROGRESS_TOLERANCE * v3_norm(direction))
+			return false;
+
+		points[*num_points] = next_point;
+		*num_points += 1;
 
 		// NOTE: If we get a degenerate simplex with the latest
 		// addition, it means it might suffer from FP precision
 		// and that we'll probably strugle to reach a proper
 		// result. In that case we just discard the point and
 		// return the current result.
-		if(gjk_check_degenerate_simplex(points, num_points)){
-			num_points -= 1;
-			goto no_overlap_result;
+		if(gjk_check_degenerate_simplex(points, *num_points)){
+			*num_points -= 1;
+			return false;
 		}
 
-		ASSERT(num_points >= 2 && num_points <= 4);
-		switch(num_points){
+		ASSERT(*num_points >= 2 && *num_points <= 4);
+		switch(*num_points){
 			case 2:
-				gjk_simplex2(points, &num_points, &direction);
+				gjk_simplex2(points, num_points, &direction);
 				break;
 			case 3:
-				gjk_simplex3(points, &num_points, &direction);
+				gjk_simplex3_reduce(points, num_points, &direction);
 				break;
 			case 4:
-				if(gjk_simplex4(points, &num_points, &direction))
-					return gjk_overlap_result();
+				if(gjk_simplex4(points, num_points, &direction))
+					return true;
 				break;
 		}
 	}
 
-no_overlap_result:
-	return gjk_no_overlap_result(points, num_points);
+	return false;
+}
+
+GJK_Result gjk(GJK_Polygon *p1, GJK_Polygon *p2){
+	i32 num_points;
+	GJK_Point points[4];
+	if(gjk_iterate(p1, p2, NULL, points, &num_points))
+		return gjk_overlap_result();
+	return gjk_no_overlap_result(points, &num_points);
+}
+
+bool gjk_simplex(GJK_Polygon *p1, GJK_Polygon *p2, Vector3 *simplex, i32 *num_points){
+	GJK_Point points[4];
+	bool result = gjk_iterate(p1, p2, NULL, points, num_points);
+	for(i32 i = 0; i < *num_points; i += 1)
+		simplex[i] = points[i].minkowski;
+	return result;
+}
+
+// ----------------------------------------------------------------
+// Mixed precision
+// ----------------------------------------------------------------
+
+struct GJK_Point64{
+	Vector3d minkowski;
+	Vector3d polygon1;
+	Vector3d polygon2;
+};
+
+static INLINE
+f64 gjk_distance2_f64(GJK_Point64 A, GJK_Point64 B,
+		Vector3d *closest1, Vector3d *closest2){
+	Vector3d AO = -A.minkowski;
+	Vector3d AB = B.minkowski - A.minkowski;
+	f64 k = v3d_dot(AO, AB) / v3d_dot(AB, AB);
+	// NOTE: The simplex was selected in f32 so `k` may end up
+	// slightly outside [0, 1] here.
+	if(k < 0.0) k = 0.0;
+	if(k > 1.0) k = 1.0;
+	Vector3d closest = A.minkowski + k * AB;
+	*closest1 = A.polygon1 + k * (B.polygon1 - A.polygon1);
+	*closest2 = A.polygon2 + k * (B.polygon2 - A.polygon2);
+	return v3d_norm(closest);
+}
+
+static INLINE
+f64 gjk_distance3_f64(GJK_Point64 A, GJK_Point64 B, GJK_Point64 C,
+		Vector3d *closest1, Vector3d *closest2){
+	// NOTE: This is the same as `gjk_distance3` with the
+	// closest point written in barycentric coordinates.
+	Vector3d AO = -A.minkowski;
+	Vector3d AB = B.minkowski - A.minkowski;
+	Vector3d AC = C.minkowski - A.minkowski;
+	Vector3d ABC = v3d_cross(AB, AC);
+	f64 inv_abc_abc = 1.0 / v3d_dot(ABC, ABC);
+	f64 kc = v3d_dot(v3d_cross(AB, AO), ABC) * inv_abc_abc;
+	f64 kb = v3d_dot(v3d_cross(AO, AC), ABC) * inv_abc_abc;
+	Vector3d closest = A.minkowski + kb * AB + kc * AC;
+	*closest1 = A.polygon1
+		+ kb * (B.polygon1 - A.polygon1)
+		+ kc * (C.polygon1 - A.polygon1);
+	*closest2 = A.polygon2
+		+ kb * (B.polygon2 - A.polygon2)
+		+ kc * (C.polygon2 - A.polygon2);
+	return v3d_norm(closest);
+}
+
+static
+GJK_Point64 gjk_point_f64(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3d origin, GJK_Point *point){
+	GJK_Point64 result;
+	result.polygon1 = make_v3d(gjk_polygon_point(p1, point->index1)) - origin
+		+ make_v3d(gjk_polygon_inflation(p1, point->dir));
+	result.polygon2 = make_v3d(gjk_polygon_point(p2, point->index2)) - origin
+		+ make_v3d(gjk_polygon_inflation(p2, -point->dir));
+	result.minkowski = result.polygon1 - result.polygon2;
+	return result;
+}
+
+GJK_Result gjk_mixed_precision(GJK_Polygon *p1, GJK_Polygon *p2){
+	ASSERT(p1->num_points > 0 && p2->num_points > 0);
+
+	// NOTE: Any point close to both polygons will do as the
+	// reference point so we just use their first vertices.
+	Vector3 origin = 0.5f * (gjk_polygon_point(p1, 0) + gjk_polygon_point(p2, 0));
+
+	i32 num_points;
+	GJK_Point points[4];
+	if(gjk_iterate(p1, p2, &origin, points, &num_points))
+		return gjk_overlap_result();
+
+	// NOTE: Move the simplex back into world space so the
+	// closest features are reported in world coordinates.
+	for(i32 i = 0; i < num_points; i += 1){
+		points[i].polygon1 = gjk_polygon_support_point(p1, points[i].index1, points[i].dir);
+		points[i].polygon2 = gjk_polygon_support_point(p2, points[i].index2, -points[i].dir);
+	}
+	GJK_Result result = gjk_no_overlap_result(points, &num_points);
+
+	// NOTE: Refine distance and closest points in f64 using the
+	// original vertices and the simplex as reduced above. The f32
+	// values above are discarded.
+	if(num_points > 1){
+		Vector3d origin64 = make_v3d(origin);
+		GJK_Point64 A = gjk_point_f64(p1, p2, origin64, &points[num_points - 1]);
+		GJK_Point64 B = gjk_point_f64(p1, p2, origin64, &points[num_points - 2]);
+		Vector3d closest1, closest2;
+		f64 distance;
+		if(num_points == 2){
+			distance = gjk_distance2_f64(A, B, &closest1, &closest2);
+		}else{
+			GJK_Point64 C = gjk_point_f64(p1, p2, origin64, &points[0]);
+			distance = gjk_distance3_f64(A, B, C, &closest1, &closest2);
+		}
+		result.distance = (f32)distance;
+		result.closest1 = make_v3(closest1 + origin64);
+		result.closest2 = make_v3(closest2 + origin64);
+	}
+	return result;
 }
@@ -4,19 +4,153 @@
 #include "common.hh"
 #include "math.hh"
 
+// NOTE: 16-bit points relative to the bounds of a polygon, 6 bytes per
+// point instead of 12 (16 with MATH_SIMD). Point `i` is `origin + scale
+// * points[3 * i ..]` per component and `error` is the largest distance
+// on each axis between a quantized point and the original one. The
+// points follow the header in memory so a query touches a single block
+// (see `gjk_quantized_size`).
+//
+//	Queries treat a quantized polygon as its quantized points inflated
+// by an `error` sized box. The box always contains the original polygon
+// so overlaps are never missed and distances are never overestimated.
+struct GJK_Quantized{
+	Vector3 origin;
+	Vector3 scale;
+	Vector3 error;
+};
+
+static INLINE
+const u16 *gjk_quantized_points(const GJK_Quantized *q){
+	return (const u16*)(q + 1);
+}
+
+static INLINE
+usize gjk_quantized_size(i32 num_points){
+	return sizeof(GJK_Quantized) + sizeof(u16) * 3 * (usize)num_points;
+}
+
+// NOTE: By default `points` is a packed array of `num_points` Vector3.
+// Polygons can also be views over existing vertex buffers:
+//	- If `stride` is not zero, vertex `i` is the three floats at
+//	`(u8*)points + stride * i`, so `points` may point at the position
+//	inside the first vertex of an interleaved buffer. It doesn't need
+//	to be aligned.
+//	- If `indices` is not NULL, point `i` of the polygon is vertex
+//	`indices[i]` so several polygons can share a vertex pool.
+//	- If `quantized` is not NULL, vertices come from it instead of
+//	`points` (see `GJK_Quantized`).
+// Always read points through `gjk_polygon_point`.
 struct GJK_Polygon{
 	i32 num_points;
 	Vector3 *points;
+	i32 stride;
+	const u32 *indices;
+	const GJK_Quantized *quantized;
+
+	// NOTE: User assigned shape identity. It's not used by the queries
+	// themselves but it's what per pair state is keyed by (see
+	// `GJK_PairCache`).
+	u32 id;
+
+	// NOTE: Optional spheres used by `gjk_collision_test_prefilter`.
+	// The outer sphere contains the whole polygon and the inner sphere
+	// is contained by it. They're only valid if `has_spheres` is set
+	// (see `gjk_polygon_compute_spheres`) and `inner_radius` may be
+	// zero if no inner sphere could be found.
+	bool has_spheres;
+	Vector3 outer_center;
+	f32 outer_radius;
+	Vector3 inner_center;
+	f32 inner_radius;
 };
 
 static INLINE
 GJK_Polygon make_gjk_polygon(Vector3 *points, i32 num_points){
-	GJK_Polygon result;
+	GJK_Polygon result = {};
 	result.num_points = num_points;
 	result.points = points;
+	result.has_spheres = false;
+	return result;
+}
+
+// NOTE: `num_points` is the number of indices if `indices` is not NULL,
+// otherwise it's the number of vertices. `offset` is the byte offset of
+// the position inside each vertex and a `stride` of zero means packed
+// Vector3 (e.g. an index list into a plain Vector3 array).
+static INLINE
+GJK_Polygon make_gjk_polygon_view(void *vertices, i32 offset, i32 stride,
+		const u32 *indices, i32 num_points){
+	ASSERT(stride == 0 || stride >= (i32)(3 * sizeof(f32)));
+	GJK_Polygon result = {};
+	result.num_points = num_points;
+	result.points = (Vector3*)((u8*)vertices + offset);
+	result.stride = stride;
+	result.indices = indices;
+	result.has_spheres = false;
+	return result;
+}
+
+// NOTE: `quantized` is referenced. See `gjk_quantize`.
+static INLINE
+GJK_Polygon make_gjk_polygon_quantized(const GJK_Quantized *quantized, i32 num_points){
+	GJK_Polygon result = {};
+	result.num_points = num_points;
+	result.quantized = quantized;
+	result.has_spheres = false;
 	return result;
 }
 
+static INLINE
+bool gjk_polygon_is_packed(const GJK_Polygon *p){
+	return p->stride == 0 && p->indices == NULL && p->quantized == NULL;
+}
+
+// NOTE: Returns the dequantized point for quantized polygons. It's within
+// `gjk_polygon_error` of the original point.
+static INLINE
+Vector3 gjk_polygon_point(const GJK_Polygon *p, i32 index){
+	if(p->indices != NULL)
+		index = (i32)p->indices[index];
+	if(p->quantized != NULL){
+		const GJK_Quantized *q = p->quantized;
+		const u16 *v = gjk_quantized_points(q) + 3 * index;
+		return q->origin + q->scale * make_v3((f32)v[0], (f32)v[1], (f32)v[2]);
+	}
+	if(p->stride == 0)
+		return p->points[index];
+	const f32 *v = (const f32*)((const u8*)p->points + (usize)p->stride * (usize)index);
+	return make_v3(v[0], v[1], v[2]);
+}
+
+static INLINE
+Vector3 gjk_polygon_error(const GJK_Polygon *p){
+	return p->quantized != NULL ? p->quantized->error : v3_zero;
+}
+
+// NOTE: Offset from a support vertex to the support point of the
+// inflated polygon in direction `dir`. It's zero unless `p` is
+// quantized.
+static INLINE
+Vector3 gjk_polygon_inflation(const GJK_Polygon *p, Vector3 dir){
+	if(p->quantized == NULL)
+		return v3_zero;
+	Vector3 e = p->quantized->error;
+	return make_v3(dir.x < 0.0f ? -e.x : e.x,
+		dir.y < 0.0f ? -e.y : e.y,
+		dir.z < 0.0f ? -e.z : e.z);
+}
+
+// NOTE: Index of the point of `p` furthest along `dir`. Quantized
+// polygons are scanned in their integer space without dequantizing
+// every point.
+i32 gjk_polygon_support_index(GJK_Polygon *p, Vector3 dir);
+
+// NOTE: Quantizes `p` relative to its bounds into `memory`, which must
+// hold `gjk_quantized_size(p->num_points)` bytes and be aligned like a
+// Vector3. Returns `memory`.
+GJK_Quantized *gjk_quantize(GJK_Polygon *p, void *memory);
+
 struct GJK_Result{
 	bool overlap;
 	f32 distance;
@@ -31,6 +165,81 @@ struct GJK_Result{
 };
 
 GJK_Result gjk(GJK_Polygon *p1, GJK_Polygon *p2);
+
+// NOTE: Runs `gjk` and returns its final simplex (up to 4 points of the
+// Minkowski difference `p1 - p2`) instead of the closest points. It's
+// meant for debugging and visualization. Returns true if the polygons
+// are overlapping.
+bool gjk_simplex(GJK_Polygon *p1, GJK_Polygon *p2, Vector3 *simplex, i32 *num_points);
+
+// NOTE: Same as `gjk` but iterations are done in f32 relative to a
+// reference point close to both polygons and the final distance and
+// closest points are recomputed in f64. Use it with polygons that are
+// far from the world origin.
+GJK_Result gjk_mixed_precision(GJK_Polygon *p1, GJK_Polygon *p2);
 bool gjk_collision_test(GJK_Polygon *p1, GJK_Polygon *p2);
 
+// NOTE: If the polygons are not overlapping, `separating_axis` is set
+// to a direction `d` for which support(p1 - p2, d) dot d < 0 and it's
+// set to zero otherwise. If it's not zero on input, it's checked first
+// with two support calls and the GJK loop is skipped if it still
+// separates the polygons. Persistent pairs should keep it around.
+bool gjk_collision_test(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 *separating_axis);
+
+// NOTE: Same as `gjk_collision_test` but if both polygons have spheres
+// it first checks for disjoint outer spheres (no overlap) and then for
+// overlapping inner spheres (overlap) before checking the separating
+// axis and running the GJK loop. Both `separating_axis` and `stats`
+// may be NULL.
+struct GJK_PrefilterStats{
+	i64 num_queries;
+	i64 num_outer_sphere;	// resolved by disjoint outer spheres
+	i64 num_inner_sphere;	// resolved by overlapping inner spheres
+	i64 num_cached_axis;	// resolved by the cached separating axis
+	i64 num_gjk;			// resolved by the GJK loop
+};
+
+bool gjk_collision_test_prefilter(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 *separating_axis, GJK_PrefilterStats *stats);
+
+// ----------------------------------------------------------------
+// Bounds
+// ----------------------------------------------------------------
+
+// NOTE: Finds the extreme vertex of `p` for each of the `num_dirs`
+// directions with a single pass over its points. The results are
+// written into `indices` which must hold `num_dirs` elements.
+#define GJK_MAX_SUPPORT_DIRS 32
+void gjk_polygon_support_multi(GJK_Polygon *p,
+		const Vector3 *dirs, i32 num_dirs, i32 *indices);
+
+// NOTE: Cached world space k-DOP of a polygon given in local space.
+// The axes are, in order, the 3 coordinate axes, the 6 edge diagonals
+// and the 4 corner diagonals, so `num_axes` = 3 gives an AABB, 9 gives
+// an 18-DOP and 13 gives a 26-DOP. The first 3 axes are always copied
+// into `aabb`.
+#define GJK_KDOP_MAX_AXES 13
+struct GJK_Bounds{
+	bool valid;
+	Transform transform;
+
+	AABB aabb;
+	i32 num_axes;
+	f32 kdop_min[GJK_KDOP_MAX_AXES];
+	f32 kdop_max[GJK_KDOP_MAX_AXES];
+};
+
+GJK_Bounds make_gjk_bounds(i32 num_axes);
+
+// NOTE: Recomputes the bounds only if `transform` is different from
+// the one used last time. Returns true if they were recomputed.
+bool gjk_bounds_update(GJK_Bounds *bounds,
+		GJK_Polygon *local, Transform *transform);
+
+// NOTE: Computes the outer and inner spheres of `p`. The spheres are
+// in the same space as the points so they must be recomputed if the
+// points change.
+void gjk_polygon_compute_spheres(GJK_Polygon *p);
+
 #endif //GJK_GJK_HH_
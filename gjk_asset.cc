@@ -0,0 +1,407 @@
+#include "gjk_asset.hh"
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+static_assert(sizeof(GJK_AssetHeader) == 56, "");
+static_assert(sizeof(GJK_AssetHull) == 88, "");
+static_assert(sizeof(GJK_AssetMesh) == 96, "");
+static_assert(sizeof(GJK_MeshNode) == 16, "");
+
+static
+u64 gjk_asset_checksum(const u8 *data, u64 size){
+	// NOTE: 64-bit FNV-1a.
+	u64 hash = 0xCBF29CE484222325ULL;
+	for(u64 i = 0; i < size; i += 1){
+		hash ^= (u64)data[i];
+		hash *= 0x100000001B3ULL;
+	}
+	return hash;
+}
+
+// NOTE: Checks that `count` elements of `element_size` bytes at `offset`
+// are inside the asset and aligned.
+static
+bool gjk_asset_check_range(GJK_Asset *asset, u64 offset, u64 count, u64 element_size){
+	if((offset % GJK_ASSET_ALIGNMENT) != 0 || offset > asset->size)
+		return false;
+	if(element_size != 0 && count > (asset->size - offset) / element_size)
+		return false;
+	return true;
+}
+
+// NOTE: Checks the contents of a hull whose ranges were already checked.
+static
+bool gjk_asset_validate_hull(GJK_Asset *asset, GJK_AssetHull *hull){
+	const u32 *offsets = (const u32*)(asset->data + hull->adjacency_offsets_offset);
+	const u32 *adjacency = (const u32*)(asset->data + hull->adjacency_offset);
+	if(offsets[0] != 0)
+		return false;
+	for(u32 i = 0; i < hull->num_points; i += 1){
+		if(offsets[i + 1] < offsets[i])
+			return false;
+	}
+	for(u32 i = 0; i < offsets[hull->num_points]; i += 1){
+		if(adjacency[i] >= hull->num_points)
+			return false;
+	}
+	return true;
+}
+
+// NOTE: Same for a mesh. Nodes are visited in depth first order and
+// `gjk_mesh_query` skips `-data` nodes when it misses an inner node so
+// subtrees must end inside the node array.
+static
+bool gjk_asset_validate_mesh(GJK_Asset *asset, GJK_AssetMesh *mesh){
+	const u32 *triangles = (const u32*)(asset->data + mesh->triangles_offset);
+	for(u64 i = 0; i < (u64)mesh->num_triangles * 3; i += 1){
+		if(triangles[i] >= mesh->num_vertices)
+			return false;
+	}
+
+	const GJK_MeshNode *nodes = (const GJK_MeshNode*)(asset->data + mesh->nodes_offset);
+	for(u32 i = 0; i < mesh->num_nodes; i += 1){
+		i32 data = nodes[i].data;
+		if(data >= 0){
+			if((u32)data >= mesh->num_triangles)
+				return false;
+		}else{
+			if(data == INT32_MIN || (u64)i + (u64)(-data) > mesh->num_nodes)
+				return false;
+		}
+	}
+	return true;
+}
+
+bool gjk_asset_from_memory(void *data, u64 size, u32 flags, GJK_Asset *asset){
+	memset(asset, 0, sizeof(GJK_Asset));
+	asset->data = (u8*)data;
+	asset->size = size;
+	if(size < sizeof(GJK_AssetHeader) || ((usize)data % GJK_ASSET_ALIGNMENT) != 0){
+		LOG_ERROR("invalid asset memory\n");
+		return false;
+	}
+
+	GJK_AssetHeader *header = (GJK_AssetHeader*)data;
+	if(header->magic != GJK_ASSET_MAGIC
+	|| header->version != GJK_ASSET_VERSION
+	|| header->header_size != sizeof(GJK_AssetHeader)
+	|| header->file_size != size){
+		LOG_ERROR("invalid asset header (version %u, expected %u)\n",
+			header->version, GJK_ASSET_VERSION);
+		return false;
+	}
+
+	if(header->point_stride != sizeof(Vector3)){
+		LOG_ERROR("asset was cooked with a different Vector3 size (%u, expected %u)\n",
+			header->point_stride, (u32)sizeof(Vector3));
+		return false;
+	}
+
+	if(!gjk_asset_check_range(asset, header->hulls_offset, header->num_hulls, sizeof(GJK_AssetHull))
+	|| !gjk_asset_check_range(asset, header->meshes_offset, header->num_meshes, sizeof(GJK_AssetMesh))){
+		LOG_ERROR("invalid asset record offsets\n");
+		return false;
+	}
+
+	asset->header = header;
+	asset->hulls = (GJK_AssetHull*)(asset->data + header->hulls_offset);
+	asset->meshes = (GJK_AssetMesh*)(asset->data + header->meshes_offset);
+
+	// NOTE: Only the records are validated here, unless the contents
+	// are validated too. It's proportional to the number of shapes and
+	// not to their size.
+	for(u32 i = 0; i < header->num_hulls; i += 1){
+		GJK_AssetHull *hull = &asset->hulls[i];
+		bool valid = gjk_asset_check_range(asset, hull->points_offset, hull->num_points, sizeof(Vector3))
+			&& gjk_asset_check_range(asset, hull->adjacency_offsets_offset, (u64)hull->num_points + 1, sizeof(u32));
+		if(valid){
+			u32 *offsets = (u32*)(asset->data + hull->adjacency_offsets_offset);
+			valid = gjk_asset_check_range(asset, hull->adjacency_offset,
+				offsets[hull->num_points], sizeof(u32));
+		}
+		if(valid && (flags & GJK_ASSET_VALIDATE_CONTENTS))
+			valid = gjk_asset_validate_hull(asset, hull);
+		if(!valid){
+			LOG_ERROR("invalid hull %u\n", i);
+			return false;
+		}
+	}
+
+	for(u32 i = 0; i < header->num_meshes; i += 1){
+		GJK_AssetMesh *mesh = &asset->meshes[i];
+		if(mesh->num_triangles == 0 || mesh->num_nodes != (2 * mesh->num_triangles - 1)
+		|| !gjk_asset_check_range(asset, mesh->vertices_offset, mesh->num_vertices, sizeof(Vector3))
+		|| !gjk_asset_check_range(asset, mesh->triangles_offset, (u64)mesh->num_triangles * 3, sizeof(u32))
+		|| !gjk_asset_check_range(asset, mesh->triangle_ids_offset, mesh->num_triangles, sizeof(u32))
+		|| !gjk_asset_check_range(asset, mesh->triangle_flags_offset, mesh->num_triangles, sizeof(u8))
+		|| !gjk_asset_check_range(asset, mesh->nodes_offset, mesh->num_nodes, sizeof(GJK_MeshNode))
+		|| ((flags & GJK_ASSET_VALIDATE_CONTENTS) && !gjk_asset_validate_mesh(asset, mesh))){
+			LOG_ERROR("invalid mesh %u\n", i);
+			return false;
+		}
+	}
+
+	if(flags & GJK_ASSET_VERIFY_CHECKSUM){
+		u64 checksum = gjk_asset_checksum(asset->data + header->header_size,
+			size - header->header_size);
+		if(checksum != header->checksum){
+			LOG_ERROR("asset checksum mismatch\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool gjk_asset_open(const char *filename, u32 flags, GJK_Asset *asset){
+	void *data = NULL;
+	u64 size = 0;
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ,
+		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(file == INVALID_HANDLE_VALUE){
+		LOG_ERROR("failed to open \"%s\"\n", filename);
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+	HANDLE mapping = NULL;
+	if(GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapping != NULL)
+		data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(data == NULL){
+		LOG_ERROR("failed to map \"%s\"\n", filename);
+		if(mapping != NULL)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	size = (u64)file_size.QuadPart;
+#else
+	int fd = open(filename, O_RDONLY);
+	if(fd == -1){
+		LOG_ERROR("failed to open \"%s\"\n", filename);
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size > 0)
+		data = mmap(NULL, (usize)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(data == NULL || data == MAP_FAILED){
+		LOG_ERROR("failed to map \"%s\"\n", filename);
+		close(fd);
+		return false;
+	}
+	size = (u64)st.st_size;
+#endif
+
+	bool result = gjk_asset_from_memory(data, size, flags, asset);
+	asset->data = (u8*)data;
+	asset->size = size;
+	asset->mapped = true;
+#if defined(_WIN32)
+	asset->file_handle = file;
+	asset->mapping_handle = mapping;
+#else
+	asset->file_handle = (void*)(usize)fd;
+#endif
+	if(!result)
+		gjk_asset_close(asset);
+	return result;
+}
+
+void gjk_asset_close(GJK_Asset *asset){
+	if(asset->mapped){
+#if defined(_WIN32)
+		UnmapViewOfFile(asset->data);
+		CloseHandle((HANDLE)asset->mapping_handle);
+		CloseHandle((HANDLE)asset->file_handle);
+#else
+		munmap(asset->data, (usize)asset->size);
+		close((int)(usize)asset->file_handle);
+#endif
+	}
+	memset(asset, 0, sizeof(GJK_Asset));
+}
+
+GJK_Polygon gjk_asset_hull_polygon(GJK_Asset *asset, i32 index){
+	ASSERT(index >= 0 && (u32)index < asset->header->num_hulls);
+	GJK_AssetHull *hull = &asset->hulls[index];
+	GJK_Polygon result = make_gjk_polygon(
+		(Vector3*)(asset->data + hull->points_offset), (i32)hull->num_points);
+	result.id = hull->id;
+	result.has_spheres = true;
+	result.outer_center = make_v3(hull->outer_center[0],
+		hull->outer_center[1], hull->outer_center[2]);
+	result.outer_radius = hull->outer_radius;
+	result.inner_center = make_v3(hull->inner_center[0],
+		hull->inner_center[1], hull->inner_center[2]);
+	result.inner_radius = hull->inner_radius;
+	return result;
+}
+
+const u32 *gjk_asset_hull_neighbors(GJK_Asset *asset, i32 index,
+		i32 vertex, i32 *num_neighbors){
+	ASSERT(index >= 0 && (u32)index < asset->header->num_hulls);
+	GJK_AssetHull *hull = &asset->hulls[index];
+	ASSERT(vertex >= 0 && (u32)vertex < hull->num_points);
+	const u32 *offsets = (const u32*)(asset->data + hull->adjacency_offsets_offset);
+	const u32 *adjacency = (const u32*)(asset->data + hull->adjacency_offset);
+	*num_neighbors = (i32)(offsets[vertex + 1] - offsets[vertex]);
+	return adjacency + offsets[vertex];
+}
+
+GJK_Mesh gjk_asset_mesh(GJK_Asset *asset, i32 index){
+	ASSERT(index >= 0 && (u32)index < asset->header->num_meshes);
+	GJK_AssetMesh *mesh = &asset->meshes[index];
+	GJK_Mesh result;
+	result.num_vertices = (i32)mesh->num_vertices;
+	result.vertices = (Vector3*)(asset->data + mesh->vertices_offset);
+	result.num_triangles = (i32)mesh->num_triangles;
+	result.triangles = (u32*)(asset->data + mesh->triangles_offset);
+	result.triangle_ids = (u32*)(asset->data + mesh->triangle_ids_offset);
+	result.triangle_flags = (u8*)(asset->data + mesh->triangle_flags_offset);
+	result.bounds = make_aabb(
+		make_v3(mesh->bounds_min[0], mesh->bounds_min[1], mesh->bounds_min[2]),
+		make_v3(mesh->bounds_max[0], mesh->bounds_max[1], mesh->bounds_max[2]));
+	result.quantize_scale = make_v3(mesh->quantize_scale[0],
+		mesh->quantize_scale[1], mesh->quantize_scale[2]);
+	result.num_nodes = (i32)mesh->num_nodes;
+	result.nodes = (GJK_MeshNode*)(asset->data + mesh->nodes_offset);
+	return result;
+}
+
+// ----------------------------------------------------------------
+// Writer
+// ----------------------------------------------------------------
+static INLINE
+u64 gjk_asset_align(u64 offset){
+	return (offset + (GJK_ASSET_ALIGNMENT - 1)) & ~(u64)(GJK_ASSET_ALIGNMENT - 1);
+}
+
+// NOTE: Reserves `size` bytes and returns their offset.
+static INLINE
+u64 gjk_asset_reserve(u64 *cursor, u64 size){
+	u64 offset = gjk_asset_align(*cursor);
+	*cursor = offset + size;
+	return offset;
+}
+
+static INLINE
+void gjk_asset_store_v3(f32 *out, const Vector3 &v){
+	out[0] = v.x;
+	out[1] = v.y;
+	out[2] = v.z;
+}
+
+bool gjk_asset_write(const char *filename,
+		GJK_Hull *hulls, const u32 *hull_ids, i32 num_hulls,
+		GJK_Mesh *meshes, i32 num_meshes){
+	// NOTE: Lay everything out first so the file can be written with a
+	// single allocation.
+	u64 cursor = sizeof(GJK_AssetHeader);
+	u64 hulls_offset = gjk_asset_reserve(&cursor, sizeof(GJK_AssetHull) * num_hulls);
+	u64 meshes_offset = gjk_asset_reserve(&cursor, sizeof(GJK_AssetMesh) * num_meshes);
+	for(i32 i = 0; i < num_hulls; i += 1){
+		GJK_Hull *hull = &hulls[i];
+		gjk_asset_reserve(&cursor, sizeof(Vector3) * hull->num_points);
+		gjk_asset_reserve(&cursor, sizeof(u32) * (hull->num_points + 1));
+		gjk_asset_reserve(&cursor, sizeof(u32) * hull->adjacency_offsets[hull->num_points]);
+	}
+	for(i32 i = 0; i < num_meshes; i += 1){
+		GJK_Mesh *mesh = &meshes[i];
+		gjk_asset_reserve(&cursor, sizeof(Vector3) * mesh->num_vertices);
+		gjk_asset_reserve(&cursor, sizeof(u32) * 3 * mesh->num_triangles);
+		gjk_asset_reserve(&cursor, sizeof(u32) * mesh->num_triangles);
+		gjk_asset_reserve(&cursor, sizeof(u8) * mesh->num_triangles);
+		gjk_asset_reserve(&cursor, sizeof(GJK_MeshNode) * mesh->num_nodes);
+	}
+	u64 file_size = gjk_asset_align(cursor);
+
+	u8 *data = (u8*)calloc((usize)file_size, 1);
+	ASSERT(data != NULL);
+	GJK_AssetHeader *header = (GJK_AssetHeader*)data;
+	header->magic = GJK_ASSET_MAGIC;
+	header->version = GJK_ASSET_VERSION;
+	header->header_size = sizeof(GJK_AssetHeader);
+	header->point_stride = sizeof(Vector3);
+	header->file_size = file_size;
+	header->num_hulls = (u32)num_hulls;
+	header->num_meshes = (u32)num_meshes;
+	header->hulls_offset = hulls_offset;
+	header->meshes_offset = meshes_offset;
+
+	// NOTE: Same order as the layout pass above.
+	cursor = meshes_offset + sizeof(GJK_AssetMesh) * num_meshes;
+	for(i32 i = 0; i < num_hulls; i += 1){
+		GJK_Hull *hull = &hulls[i];
+		GJK_AssetHull *record = &((GJK_AssetHull*)(data + hulls_offset))[i];
+		u32 num_adjacency = hull->adjacency_offsets[hull->num_points];
+		record->id = hull_ids[i];
+		record->num_points = (u32)hull->num_points;
+		record->points_offset = gjk_asset_reserve(&cursor, sizeof(Vector3) * hull->num_points);
+		record->adjacency_offsets_offset = gjk_asset_reserve(&cursor, sizeof(u32) * (hull->num_points + 1));
+		record->adjacency_offset = gjk_asset_reserve(&cursor, sizeof(u32) * num_adjacency);
+		memcpy(data + record->points_offset, hull->points, sizeof(Vector3) * hull->num_points);
+		memcpy(data + record->adjacency_offsets_offset, hull->adjacency_offsets,
+			sizeof(u32) * (hull->num_points + 1));
+		memcpy(data + record->adjacency_offset, hull->adjacency, sizeof(u32) * num_adjacency);
+
+		GJK_Polygon polygon = gjk_hull_polygon(hull);
+		gjk_polygon_compute_spheres(&polygon);
+		AABB bounds = make_aabb(hull->points[0], hull->points[0]);
+		for(i32 j = 1; j < hull->num_points; j += 1)
+			bounds = aabb_union(bounds, make_aabb(hull->points[j], hull->points[j]));
+		gjk_asset_store_v3(record->bounds_min, bounds.min);
+		gjk_asset_store_v3(record->bounds_max, bounds.max);
+		gjk_asset_store_v3(record->outer_center, polygon.outer_center);
+		record->outer_radius = polygon.outer_radius;
+		gjk_asset_store_v3(record->inner_center, polygon.inner_center);
+		record->inner_radius = polygon.inner_radius;
+	}
+
+	for(i32 i = 0; i < num_meshes; i += 1){
+		GJK_Mesh *mesh = &meshes[i];
+		GJK_AssetMesh *record = &((GJK_AssetMesh*)(data + meshes_offset))[i];
+		record->id = (u32)i;
+		record->num_vertices = (u32)mesh->num_vertices;
+		record->num_triangles = (u32)mesh->num_triangles;
+		record->num_nodes = (u32)mesh->num_nodes;
+		record->vertices_offset = gjk_asset_reserve(&cursor, sizeof(Vector3) * mesh->num_vertices);
+		record->triangles_offset = gjk_asset_reserve(&cursor, sizeof(u32) * 3 * mesh->num_triangles);
+		record->triangle_ids_offset = gjk_asset_reserve(&cursor, sizeof(u32) * mesh->num_triangles);
+		record->triangle_flags_offset = gjk_asset_reserve(&cursor, sizeof(u8) * mesh->num_triangles);
+		record->nodes_offset = gjk_asset_reserve(&cursor, sizeof(GJK_MeshNode) * mesh->num_nodes);
+		memcpy(data + record->vertices_offset, mesh->vertices, sizeof(Vector3) * mesh->num_vertices);
+		memcpy(data + record->triangles_offset, mesh->triangles, sizeof(u32) * 3 * mesh->num_triangles);
+		memcpy(data + record->triangle_ids_offset, mesh->triangle_ids, sizeof(u32) * mesh->num_triangles);
+		memcpy(data + record->triangle_flags_offset, mesh->triangle_flags, sizeof(u8) * mesh->num_triangles);
+		memcpy(data + record->nodes_offset, mesh->nodes, sizeof(GJK_MeshNode) * mesh->num_nodes);
+		gjk_asset_store_v3(record->bounds_min, mesh->bounds.min);
+		gjk_asset_store_v3(record->bounds_max, mesh->bounds.max);
+		gjk_asset_store_v3(record->quantize_scale, mesh->quantize_scale);
+	}
+	ASSERT(gjk_asset_align(cursor) == file_size);
+
+	header->checksum = gjk_asset_checksum(data + sizeof(GJK_AssetHeader),
+		file_size - sizeof(GJK_AssetHeader));
+
+	bool result = false;
+	FILE *file = fopen(filename, "wb");
+	if(file != NULL){
+		result = fwrite(data, 1, (usize)file_size, file) == (usize)file_size;
+		result = (fclose(file) == 0) && result;
+	}
+	if(!result)
+		LOG_ERROR("failed to write \"%s\"\n", filename);
+	free(data);
+	return result;
+}
@@ -0,0 +1,127 @@
+#ifndef GJK_GJK_ASSET_HH_
+#define GJK_GJK_ASSET_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+#include "gjk_hull.hh"
+#include "gjk_mesh.hh"
+
+// NOTE: Cooked collision assets. The file is meant to be mapped into
+// memory and used in place: every reference is an offset from the start
+// of the file and every array is aligned to GJK_ASSET_ALIGNMENT so
+// loading is just validating the header and the records.
+//
+//	Points and mesh vertices are stored as Vector3 so they can be used
+// directly by `gjk`. Vector3 is 12 bytes with the scalar backend and 16
+// with MATH_SIMD so `point_stride` records the size used when cooking
+// and the file is rejected if it doesn't match. Everything else has the
+// same layout in both.
+//
+//	`checksum` is the 64-bit FNV-1a of everything after the header.
+//
+//	Loading always checks the header and that every record's arrays are
+// inside the file, which only costs a pass over the records. The
+// contents of those arrays (triangle vertex indices, BVH node triangles
+// and subtree sizes, hull adjacency offsets and neighbors) are TRUSTED
+// by default: a corrupt file can pass these checks and then read out
+// of bounds in mesh and hull queries. Both checks below read the whole
+// file so they're opt in:
+//	- GJK_ASSET_VERIFY_CHECKSUM catches files corrupted after cooking
+// but not files written badly on purpose.
+//	- GJK_ASSET_VALIDATE_CONTENTS checks every index against the array
+// it points into, which makes the asset safe to query whatever the
+// file contains.
+// Assets that don't come from a trusted cook step should be opened
+// with GJK_ASSET_VALIDATE_CONTENTS.
+#define GJK_ASSET_MAGIC 0x414B4A47 // "GJKA"
+#define GJK_ASSET_VERSION 1
+#define GJK_ASSET_ALIGNMENT 16
+
+#define GJK_ASSET_VERIFY_CHECKSUM 0x01
+#define GJK_ASSET_VALIDATE_CONTENTS 0x02
+
+struct GJK_AssetHeader{
+	u32 magic;
+	u32 version;
+	u32 header_size;
+	u32 point_stride;
+	u64 file_size;
+	u64 checksum;
+
+	u32 num_hulls;
+	u32 num_meshes;
+	u64 hulls_offset;
+	u64 meshes_offset;
+};
+
+// NOTE: The neighbours of vertex `i` are `adjacency[adjacency_offsets[i]
+// .. adjacency_offsets[i + 1])`, same as in `GJK_Hull`.
+struct GJK_AssetHull{
+	u32 id;
+	u32 num_points;
+	u64 points_offset;
+	u64 adjacency_offsets_offset;
+	u64 adjacency_offset;
+
+	f32 bounds_min[3];
+	f32 bounds_max[3];
+	f32 outer_center[3];
+	f32 outer_radius;
+	f32 inner_center[3];
+	f32 inner_radius;
+};
+
+struct GJK_AssetMesh{
+	u32 id;
+	u32 num_vertices;
+	u32 num_triangles;
+	u32 num_nodes;
+	u64 vertices_offset;
+	u64 triangles_offset;
+	u64 triangle_ids_offset;
+	u64 triangle_flags_offset;
+	u64 nodes_offset;
+
+	f32 bounds_min[3];
+	f32 bounds_max[3];
+	f32 quantize_scale[3];
+	u32 reserved;
+};
+
+struct GJK_Asset{
+	u8 *data;
+	u64 size;
+	GJK_AssetHeader *header;
+	GJK_AssetHull *hulls;
+	GJK_AssetMesh *meshes;
+
+	// NOTE: Only set for assets opened with `gjk_asset_open`.
+	bool mapped;
+	void *file_handle;
+	void *mapping_handle;
+};
+
+// NOTE: Both return false if the data is not a valid asset. `flags` are
+// GJK_ASSET_* flags (see above). Assets from memory reference `data`
+// which must stay alive (and aligned to at least GJK_ASSET_ALIGNMENT)
+// until the asset is closed.
+bool gjk_asset_open(const char *filename, u32 flags, GJK_Asset *asset);
+bool gjk_asset_from_memory(void *data, u64 size, u32 flags, GJK_Asset *asset);
+void gjk_asset_close(GJK_Asset *asset);
+
+// NOTE: These return views into the asset memory. The polygon has its
+// spheres set from the cooked values and the mesh must NOT be freed
+// with `gjk_mesh_free`.
+GJK_Polygon gjk_asset_hull_polygon(GJK_Asset *asset, i32 index);
+const u32 *gjk_asset_hull_neighbors(GJK_Asset *asset, i32 index,
+		i32 vertex, i32 *num_neighbors);
+GJK_Mesh gjk_asset_mesh(GJK_Asset *asset, i32 index);
+
+// NOTE: Cooks the hulls (with the given ids) and meshes into `filename`.
+// Mesh ids are their index.
+bool gjk_asset_write(const char *filename,
+		GJK_Hull *hulls, const u32 *hull_ids, i32 num_hulls,
+		GJK_Mesh *meshes, i32 num_meshes);
+
+#endif //GJK_GJK_ASSET_HH_
@@ -0,0 +1,262 @@
+// NOTE: Computing an AABB or k-DOP takes one support query per
+// direction. Doing each one separately means one full pass over
+// the polygon per direction so we do them all at once instead.
+
+#include "gjk.hh"
+
+void gjk_polygon_support_multi(GJK_Polygon *p,
+		const Vector3 *dirs, i32 num_dirs, i32 *indices){
+	ASSERT(p->num_points > 0);
+	ASSERT(num_dirs > 0 && num_dirs <= GJK_MAX_SUPPORT_DIRS);
+
+	f32 max[GJK_MAX_SUPPORT_DIRS];
+	for(i32 k = 0; k < num_dirs; k += 1){
+		max[k] = v3_dot(gjk_polygon_point(p, 0), dirs[k]);
+		indices[k] = 0;
+	}
+
+	for(i32 i = 1; i < p->num_points; i += 1){
+		Vector3 point = gjk_polygon_point(p, i);
+		for(i32 k = 0; k < num_dirs; k += 1){
+			f32 dot = v3_dot(point, dirs[k]);
+			if(dot > max[k]){
+				max[k] = dot;
+				indices[k] = i;
+			}
+		}
+	}
+}
+
+// NOTE: Unnormalized k-DOP axes. See `GJK_Bounds`.
+static const f32 gjk_kdop_axes[GJK_KDOP_MAX_AXES][3] = {
+	// coordinate axes
+	{ 1.0f,  0.0f,  0.0f},
+	{ 0.0f,  1.0f,  0.0f},
+	{ 0.0f,  0.0f,  1.0f},
+	// edge diagonals
+	{ 1.0f,  1.0f,  0.0f},
+	{ 1.0f, -1.0f,  0.0f},
+	{ 1.0f,  0.0f,  1.0f},
+	{ 1.0f,  0.0f, -1.0f},
+	{ 0.0f,  1.0f,  1.0f},
+	{ 0.0f,  1.0f, -1.0f},
+	// corner diagonals
+	{ 1.0f,  1.0f,  1.0f},
+	{ 1.0f, -1.0f,  1.0f},
+	{ 1.0f,  1.0f, -1.0f},
+	{ 1.0f, -1.0f, -1.0f},
+};
+
+GJK_Bounds make_gjk_bounds(i32 num_axes){
+	ASSERT(num_axes == 3 || num_axes == 9 || num_axes == 13);
+	GJK_Bounds result = {};
+	result.valid = false;
+	result.num_axes = num_axes;
+	return result;
+}
+
+static INLINE
+bool gjk_transform_equal(Transform *a, Transform *b){
+	return a->rotation.w == b->rotation.w
+		&& a->rotation.x == b->rotation.x
+		&& a->rotation.y == b->rotation.y
+		&& a->rotation.z == b->rotation.z
+		&& a->translation == b->translation;
+}
+
+bool gjk_bounds_update(GJK_Bounds *bounds,
+		GJK_Polygon *local, Transform *transform){
+	if(bounds->valid && gjk_transform_equal(&bounds->transform, transform))
+		return false;
+
+	// NOTE: The support of the transformed polygon in direction `d`
+	// is the transformed support of the local polygon in direction
+	// conj(rotation) * d. This way we don't need to transform every
+	// point to compute the bounds.
+	Quaternion inv_rotation = make_quat(transform->rotation.w,
+		-transform->rotation.x, -transform->rotation.y, -transform->rotation.z);
+
+	i32 num_axes = bounds->num_axes;
+	i32 num_dirs = 2 * num_axes;
+	Vector3 world_dirs[GJK_MAX_SUPPORT_DIRS];
+	Vector3 local_dirs[GJK_MAX_SUPPORT_DIRS];
+	for(i32 i = 0; i < num_axes; i += 1){
+		Vector3 axis = make_v3(gjk_kdop_axes[i][0],
+			gjk_kdop_axes[i][1], gjk_kdop_axes[i][2]);
+		world_dirs[2 * i + 0] = axis;
+		world_dirs[2 * i + 1] = -axis;
+		local_dirs[2 * i + 0] = v3_rotate(axis, inv_rotation);
+		local_dirs[2 * i + 1] = -local_dirs[2 * i + 0];
+	}
+
+	i32 indices[GJK_MAX_SUPPORT_DIRS];
+	gjk_polygon_support_multi(local, local_dirs, num_dirs, indices);
+
+	for(i32 i = 0; i < num_axes; i += 1){
+		Vector3 max_point = transform_point(*transform, gjk_polygon_point(local, indices[2 * i + 0])
+			+ gjk_polygon_inflation(local, local_dirs[2 * i + 0]));
+		Vector3 min_point = transform_point(*transform, gjk_polygon_point(local, indices[2 * i + 1])
+			+ gjk_polygon_inflation(local, local_dirs[2 * i + 1]));
+		bounds->kdop_max[i] = v3_dot(max_point, world_dirs[2 * i + 0]);
+		bounds->kdop_min[i] = v3_dot(min_point, world_dirs[2 * i + 0]);
+	}
+
+	bounds->aabb.min = make_v3(bounds->kdop_min[0],
+		bounds->kdop_min[1], bounds->kdop_min[2]);
+	bounds->aabb.max = make_v3(bounds->kdop_max[0],
+		bounds->kdop_max[1], bounds->kdop_max[2]);
+	bounds->transform = *transform;
+	bounds->valid = true;
+	return true;
+}
+
+// NOTE: Writes the insphere of the tetrahedron ABCD. Returns false
+// if the tetrahedron is degenerate.
+static
+bool gjk_tetrahedron_insphere(Vector3 A, Vector3 B, Vector3 C, Vector3 D,
+		Vector3 *center, f32 *radius){
+	f32 volume = (1.0f / 6.0f) * f32_abs(v3_dot(B - A, v3_cross(C - A, D - A)));
+	if(f32_cmp_zero(volume))
+		return false;
+
+	// NOTE: The incenter is the average of the vertices weighted
+	// by the area of the opposite face.
+	f32 area_a = 0.5f * v3_norm(v3_cross(C - B, D - B));
+	f32 area_b = 0.5f * v3_norm(v3_cross(C - A, D - A));
+	f32 area_c = 0.5f * v3_norm(v3_cross(B - A, D - A));
+	f32 area_d = 0.5f * v3_norm(v3_cross(B - A, C - A));
+	f32 total_area = area_a + area_b + area_c + area_d;
+	*center = (1.0f / total_area)
+		* (area_a * A + area_b * B + area_c * C + area_d * D);
+	*radius = 3.0f * volume / total_area;
+	return true;
+}
+
+void gjk_polygon_compute_spheres(GJK_Polygon *p){
+	ASSERT(p->num_points > 0);
+
+	// NOTE: The extreme points along the coordinate axes give us
+	// the AABB for the outer sphere and a good first guess for
+	// the inner tetrahedron.
+	Vector3 dirs[6] = {
+		make_v3( 1.0f,  0.0f,  0.0f), make_v3(-1.0f,  0.0f,  0.0f),
+		make_v3( 0.0f,  1.0f,  0.0f), make_v3( 0.0f, -1.0f,  0.0f),
+		make_v3( 0.0f,  0.0f,  1.0f), make_v3( 0.0f,  0.0f, -1.0f),
+	};
+	i32 extremes[6];
+	gjk_polygon_support_multi(p, dirs, 6, extremes);
+
+	// outer sphere
+	Vector3 min = make_v3(gjk_polygon_point(p, extremes[1]).x,
+		gjk_polygon_point(p, extremes[3]).y, gjk_polygon_point(p, extremes[5]).z);
+	Vector3 max = make_v3(gjk_polygon_point(p, extremes[0]).x,
+		gjk_polygon_point(p, extremes[2]).y, gjk_polygon_point(p, extremes[4]).z);
+	Vector3 outer_center = 0.5f * (min + max);
+	f32 outer_radius2 = 0.0f;
+	for(i32 i = 0; i < p->num_points; i += 1){
+		f32 dist2 = v3_norm2(gjk_polygon_point(p, i) - outer_center);
+		if(dist2 > outer_radius2)
+			outer_radius2 = dist2;
+	}
+
+	// NOTE: Any tetrahedron made from the polygon's points is inside
+	// the polygon so its insphere is a conservative inner sphere. We
+	// pick it the same way quickhull picks its initial simplex.
+	Vector3 inner_center = outer_center;
+	f32 inner_radius = 0.0f;
+	if(p->num_points >= 4){
+		i32 a = extremes[0];
+		i32 b = extremes[1];
+		f32 max_spread = v3_norm2(gjk_polygon_point(p, a) - gjk_polygon_point(p, b));
+		for(i32 k = 1; k < 3; k += 1){
+			f32 spread = v3_norm2(gjk_polygon_point(p, extremes[2 * k])
+				- gjk_polygon_point(p, extremes[2 * k + 1]));
+			if(spread > max_spread){
+				max_spread = spread;
+				a = extremes[2 * k];
+				b = extremes[2 * k + 1];
+			}
+		}
+
+		Vector3 A = gjk_polygon_point(p, a);
+		Vector3 AB = gjk_polygon_point(p, b) - A;
+		i32 c = a;
+		f32 max_line_dist2 = 0.0f;
+		for(i32 i = 0; i < p->num_points; i += 1){
+			f32 dist2 = v3_norm2(v3_cross(AB, gjk_polygon_point(p, i) - A));
+			if(dist2 > max_line_dist2){
+				max_line_dist2 = dist2;
+				c = i;
+			}
+		}
+
+		Vector3 ABC = v3_cross(AB, gjk_polygon_point(p, c) - A);
+		i32 d = a;
+		f32 max_plane_dist = 0.0f;
+		for(i32 i = 0; i < p->num_points; i += 1){
+			f32 dist = f32_abs(v3_dot(ABC, gjk_polygon_point(p, i) - A));
+			if(dist > max_plane_dist){
+				max_plane_dist = dist;
+				d = i;
+			}
+		}
+
+		if(!gjk_tetrahedron_insphere(A, gjk_polygon_point(p, b), gjk_polygon_point(p, c),
+				gjk_polygon_point(p, d), &inner_center, &inner_radius)){
+			inner_center = outer_center;
+			inner_radius = 0.0f;
+		}
+	}
+
+	// NOTE: Quantized polygons are inflated (see `GJK_Quantized`) which
+	// only grows the outer sphere.
+	p->has_spheres = true;
+	p->outer_center = outer_center;
+	p->outer_radius = sqrtf(outer_radius2) + v3_norm(gjk_polygon_error(p));
+	p->inner_center = inner_center;
+	p->inner_radius = inner_radius;
+}
+
+GJK_Quantized *gjk_quantize(GJK_Polygon *p, void *memory){
+	ASSERT(p->num_points > 0);
+	ASSERT(((usize)memory % alignof(Vector3)) == 0);
+	Vector3 min = gjk_polygon_point(p, 0);
+	Vector3 max = min;
+	for(i32 i = 1; i < p->num_points; i += 1){
+		Vector3 point = gjk_polygon_point(p, i);
+		min = make_v3(f32_min(min.x, point.x), f32_min(min.y, point.y), f32_min(min.z, point.z));
+		max = make_v3(f32_max(max.x, point.x), f32_max(max.y, point.y), f32_max(max.z, point.z));
+	}
+
+	GJK_Quantized *result = (GJK_Quantized*)memory;
+	u16 *points = (u16*)(result + 1);
+	result->origin = min;
+	result->scale = (1.0f / 65535.0f) * (max - min);
+
+	f32 inv_scale[3];
+	for(i32 k = 0; k < 3; k += 1){
+		f32 scale = v3_axis(result->scale, k);
+		inv_scale[k] = scale > 0.0f ? 1.0f / scale : 0.0f;
+	}
+
+	// NOTE: The error is measured with the same dequantization that the
+	// queries use so it accounts for rounding on both ends.
+	f32 error[3] = {};
+	for(i32 i = 0; i < p->num_points; i += 1){
+		Vector3 point = gjk_polygon_point(p, i);
+		Vector3 local = point - result->origin;
+		for(i32 k = 0; k < 3; k += 1){
+			f32 q = f32_clamp(v3_axis(local, k) * inv_scale[k] + 0.5f, 0.0f, 65535.0f);
+			points[3 * i + k] = (u16)q;
+		}
+
+		const u16 *v = &points[3 * i];
+		Vector3 dequantized = result->origin
+			+ result->scale * make_v3((f32)v[0], (f32)v[1], (f32)v[2]);
+		Vector3 diff = v3_abs(dequantized - point);
+		for(i32 k = 0; k < 3; k += 1)
+			error[k] = f32_max(error[k], v3_axis(diff, k));
+	}
+	result->error = make_v3(error[0], error[1], error[2]);
+	return result;
+}
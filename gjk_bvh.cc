@@ -0,0 +1,102 @@
+#include "gjk_bvh.hh"
+
+static INLINE
+f32 gjk_bvh_centroid(const AABB &bounds, i32 axis){
+	return v3_axis(bounds.min, axis) + v3_axis(bounds.max, axis);
+}
+
+// NOTE: Quickselect so that `indices[k]` ends up with the k-th
+// smallest centroid along `axis`, with smaller ones before it and
+// larger ones after it.
+static
+void gjk_bvh_select(const AABB *bounds, i32 *indices, i32 count, i32 k, i32 axis){
+	i32 lo = 0;
+	i32 hi = count - 1;
+	while(lo < hi){
+		f32 pivot = gjk_bvh_centroid(bounds[indices[(lo + hi) / 2]], axis);
+		i32 i = lo;
+		i32 j = hi;
+		while(i <= j){
+			while(gjk_bvh_centroid(bounds[indices[i]], axis) < pivot) i += 1;
+			while(gjk_bvh_centroid(bounds[indices[j]], axis) > pivot) j -= 1;
+			if(i <= j){
+				i32 tmp = indices[i];
+				indices[i] = indices[j];
+				indices[j] = tmp;
+				i += 1;
+				j -= 1;
+			}
+		}
+		if(k <= j)
+			hi = j;
+		else if(k >= i)
+			lo = i;
+		else
+			break;
+	}
+}
+
+static
+void gjk_bvh_build_node(GJK_BVH *bvh, const AABB *bounds,
+		i32 node_index, i32 first, i32 count, i32 depth){
+	GJK_BVHNode *node = &bvh->nodes[node_index];
+	AABB node_bounds = bounds[bvh->indices[first]];
+	AABB centroid_bounds = make_aabb(
+		(node_bounds.min + node_bounds.max) * 0.5f,
+		(node_bounds.min + node_bounds.max) * 0.5f);
+	for(i32 i = 1; i < count; i += 1){
+		AABB b = bounds[bvh->indices[first + i]];
+		Vector3 centroid = (b.min + b.max) * 0.5f;
+		node_bounds = aabb_union(node_bounds, b);
+		centroid_bounds = aabb_union(centroid_bounds, make_aabb(centroid, centroid));
+	}
+	node->bounds = node_bounds;
+
+	// NOTE: The median split keeps the tree balanced so this should
+	// only trigger with absurdly large inputs.
+	ASSERT(depth < GJK_BVH_MAX_DEPTH);
+	if(count <= GJK_BVH_LEAF_SIZE){
+		node->first = first;
+		node->count = count;
+		return;
+	}
+
+	Vector3 extent = centroid_bounds.max - centroid_bounds.min;
+	i32 axis = 0;
+	if(extent.y > v3_axis(extent, axis)) axis = 1;
+	if(extent.z > v3_axis(extent, axis)) axis = 2;
+
+	i32 half = count / 2;
+	gjk_bvh_select(bounds, bvh->indices + first, count, half, axis);
+
+	i32 left = bvh->num_nodes;
+	bvh->num_nodes += 2;
+	node->first = left;
+	node->count = 0;
+	gjk_bvh_build_node(bvh, bounds, left, first, half, depth + 1);
+	gjk_bvh_build_node(bvh, bounds, left + 1, first + half, count - half, depth + 1);
+}
+
+GJK_BVH gjk_bvh_build(const AABB *bounds, i32 count){
+	ASSERT(count > 0);
+	GJK_BVH result;
+	result.num_nodes = 1;
+	result.nodes = (GJK_BVHNode*)malloc(sizeof(GJK_BVHNode) * (2 * count - 1));
+	result.num_indices = count;
+	result.indices = (i32*)malloc(sizeof(i32) * count);
+	ASSERT(result.nodes != NULL && result.indices != NULL);
+	for(i32 i = 0; i < count; i += 1)
+		result.indices[i] = i;
+	gjk_bvh_build_node(&result, bounds, 0, 0, count, 0);
+	ASSERT(result.num_nodes <= 2 * count - 1);
+	return result;
+}
+
+void gjk_bvh_free(GJK_BVH *bvh){
+	free(bvh->nodes);
+	free(bvh->indices);
+	bvh->nodes = NULL;
+	bvh->indices = NULL;
+	bvh->num_nodes = 0;
+	bvh->num_indices = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef GJK_GJK_BVH_HH_
+#define GJK_GJK_BVH_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+
+// NOTE: Static bounding volume hierarchy over a set of AABBs. Nodes
+// are stored in a flat array with the root at index 0. Leaves have
+// `count` > 0 and reference `indices[first .. first + count)` while
+// inner nodes have `count` = 0 and their children at `first` and
+// `first + 1`.
+#define GJK_BVH_LEAF_SIZE 2
+#define GJK_BVH_MAX_DEPTH 64
+
+struct GJK_BVHNode{
+	AABB bounds;
+	i32 first;
+	i32 count;
+};
+
+struct GJK_BVH{
+	i32 num_nodes;
+	GJK_BVHNode *nodes;
+	i32 num_indices;
+	i32 *indices;
+};
+
+// NOTE: Splits at the median of the longest centroid axis. The bounds
+// are not referenced after it returns.
+GJK_BVH gjk_bvh_build(const AABB *bounds, i32 count);
+void gjk_bvh_free(GJK_BVH *bvh);
+
+#endif //GJK_GJK_BVH_HH_
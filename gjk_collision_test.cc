@@ -120,46 +120,45 @@ bool gjk_collistion_test_simplex4(Vector3 *points, i32 *num_points, Vector3 *nex
 static
 Vector3 gjk_polygon_support(GJK_Polygon *p1, GJK_Polygon *p2, Vector3 dir){
 	ASSERT(p1->num_points > 0 && p2->num_points > 0);
+	i32 index1 = gjk_polygon_support_index(p1, dir);
+	i32 index2 = gjk_polygon_support_index(p2, -dir);
+	Vector3 result = (gjk_polygon_point(p1, index1) + gjk_polygon_inflation(p1, dir))
+		- (gjk_polygon_point(p2, index2) + gjk_polygon_inflation(p2, -dir));
+	return result;
+}
 
-	i32 index1 = 0;
-	f32 max1 = v3_dot(p1->points[0], dir);
-
-	i32 index2 = 0;
-	f32 max2 = v3_dot(p2->points[0], -dir);
-
-	i32 imax = i32_max(p1->num_points, p2->num_points);
-	for(i32 i = 1; i < imax; i += 1){
-		if(i < p1->num_points){
-			f32 dot = v3_dot(p1->points[i], dir);
-			if(dot > max1){
-				max1 = dot;
-				index1 = i;
-			}
-		}
-
-		if(i < p2->num_points){
-			f32 dot = v3_dot(p2->points[i], -dir);
-			if(dot > max2){
-				max2 = dot;
-				index2 = i;
-			}
+static
+bool gjk_collision_test_cached(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 *separating_axis, GJK_PrefilterStats *stats){
+	Vector3 initial_point;
+	if(separating_axis && !v3_cmp_zero(*separating_axis)){
+		// NOTE: If the cached axis still separates the polygons, two
+		// support calls (one for each polygon) are enough. Otherwise
+		// the point we got is as good as any to start the loop.
+		initial_point = gjk_polygon_support(p1, p2, *separating_axis);
+		if(v3_dot(*separating_axis, initial_point) < 0){
+			if(stats)
+				stats->num_cached_axis += 1;
+			return false;
 		}
+	}else{
+		initial_point = gjk_polygon_support(
+			p1, p2, make_v3(0.0f, 0.0f, -1.0f));
 	}
 
-	Vector3 result = p1->points[index1] - p2->points[index2];
-	return result;
-}
+	if(stats)
+		stats->num_gjk += 1;
 
-bool gjk_collision_test(GJK_Polygon *p1, GJK_Polygon *p2){
-	Vector3 initial_point = gjk_polygon_support(
-			p1, p2, make_v3(0.0f, 0.0f, -1.0f));
 	i32 num_points = 1;
 	Vector3 points[4] = { initial_point };
 	Vector3 dir = -initial_point;
 	while(1){
 		Vector3 new_point = gjk_polygon_support(p1, p2, dir);
-		if(v3_dot(dir, new_point) < 0)
+		if(v3_dot(dir, new_point) < 0){
+			if(separating_axis)
+				*separating_axis = dir;
 			return false;
+		}
 
 		points[num_points] = new_point;
 		num_points += 1;
@@ -173,9 +172,52 @@ bool gjk_collision_test(GJK_Polygon *p1, GJK_Polygon *p2){
 				gjk_collistion_test_simplex3(points, &num_points, &dir);
 				break;
 			case 4:
-				if(gjk_collistion_test_simplex4(points, &num_points, &dir))
+				if(gjk_collistion_test_simplex4(points, &num_points, &dir)){
+					if(separating_axis)
+						*separating_axis = v3_zero;
 					return true;
+				}
 				break;
 		}
 	}
 }
+
+bool gjk_collision_test(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 *separating_axis){
+	return gjk_collision_test_cached(p1, p2, separating_axis, NULL);
+}
+
+bool gjk_collision_test(GJK_Polygon *p1, GJK_Polygon *p2){
+	return gjk_collision_test_cached(p1, p2, NULL, NULL);
+}
+
+bool gjk_collision_test_prefilter(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 *separating_axis, GJK_PrefilterStats *stats){
+	if(stats)
+		stats->num_queries += 1;
+
+	if(p1->has_spheres && p2->has_spheres){
+		f32 outer_radius = p1->outer_radius + p2->outer_radius;
+		f32 outer_dist2 = v3_norm2(p2->outer_center - p1->outer_center);
+		if(outer_dist2 > outer_radius * outer_radius){
+			if(stats)
+				stats->num_outer_sphere += 1;
+			return false;
+		}
+
+		// NOTE: The inner center is only guaranteed to be inside the
+		// polygon when the inner radius is not zero.
+		f32 inner_radius = p1->inner_radius + p2->inner_radius;
+		f32 inner_dist2 = v3_norm2(p2->inner_center - p1->inner_center);
+		if(p1->inner_radius > 0.0f && p2->inner_radius > 0.0f
+				&& inner_dist2 < inner_radius * inner_radius){
+			if(stats)
+				stats->num_inner_sphere += 1;
+			if(separating_axis)
+				*separating_axis = v3_zero;
+			return true;
+		}
+	}
+
+	return gjk_collision_test_cached(p1, p2, separating_axis, stats);
+}
@@ -0,0 +1,262 @@
+#include "gjk_compound.hh"
+
+// NOTE: Precomputed rotation columns to move boxes between spaces. The
+// transformed box is the AABB of the rotated box so it's conservative.
+struct GJK_BoxTransform{
+	Vector3 abs_col[3];
+	Transform transform;
+};
+
+static
+GJK_BoxTransform make_box_transform(const Transform &t){
+	GJK_BoxTransform result;
+	result.abs_col[0] = v3_abs(v3_rotate(make_v3(1.0f, 0.0f, 0.0f), t.rotation));
+	result.abs_col[1] = v3_abs(v3_rotate(make_v3(0.0f, 1.0f, 0.0f), t.rotation));
+	result.abs_col[2] = v3_abs(v3_rotate(make_v3(0.0f, 0.0f, 1.0f), t.rotation));
+	result.transform = t;
+	return result;
+}
+
+static INLINE
+AABB gjk_box_transform(const GJK_BoxTransform &bt, const AABB &box){
+	Vector3 center = transform_point(bt.transform, (box.min + box.max) * 0.5f);
+	Vector3 half = (box.max - box.min) * 0.5f;
+	Vector3 extent = bt.abs_col[0] * half.x
+		+ bt.abs_col[1] * half.y
+		+ bt.abs_col[2] * half.z;
+	return make_aabb(center - extent, center + extent);
+}
+
+static INLINE
+AABB gjk_box_expand(const AABB &box, f32 margin){
+	Vector3 m = make_v3(margin, margin, margin);
+	return make_aabb(box.min - m, box.max + m);
+}
+
+static
+AABB gjk_points_bounds(const Transform &t, GJK_Polygon *polygon){
+	ASSERT(polygon->num_points > 0);
+	Vector3 p = transform_point(t, gjk_polygon_point(polygon, 0));
+	AABB result = make_aabb(p, p);
+	for(i32 i = 1; i < polygon->num_points; i += 1){
+		p = transform_point(t, gjk_polygon_point(polygon, i));
+		result = aabb_union(result, make_aabb(p, p));
+	}
+
+	// NOTE: Quantized polygons are inflated by a box aligned with
+	// their own axes.
+	if(polygon->quantized != NULL){
+		GJK_BoxTransform bt = make_box_transform(t);
+		Vector3 e = polygon->quantized->error;
+		Vector3 extent = bt.abs_col[0] * e.x
+			+ bt.abs_col[1] * e.y
+			+ bt.abs_col[2] * e.z;
+		result.min -= extent;
+		result.max += extent;
+	}
+	return result;
+}
+
+GJK_Compound gjk_compound_create(i32 num_children,
+		GJK_Polygon *children, Transform *child_transforms){
+	ASSERT(num_children > 0);
+	GJK_Compound result;
+	result.num_children = num_children;
+	result.children = (GJK_CompoundChild*)malloc(sizeof(GJK_CompoundChild) * num_children);
+	ASSERT(result.children != NULL);
+
+	AABB *bounds = (AABB*)malloc(sizeof(AABB) * num_children);
+	ASSERT(bounds != NULL);
+	for(i32 i = 0; i < num_children; i += 1){
+		GJK_CompoundChild *child = &result.children[i];
+		child->local = children[i];
+		child->transform = child_transforms[i];
+		child->bounds = gjk_points_bounds(child->transform, &child->local);
+		bounds[i] = child->bounds;
+
+		Vector3 *world_points = (Vector3*)malloc(sizeof(Vector3) * child->local.num_points);
+		ASSERT(world_points != NULL);
+		child->world = make_gjk_polygon(world_points, child->local.num_points);
+		child->world.id = child->local.id;
+		child->world_version = 0;
+	}
+	result.bvh = gjk_bvh_build(bounds, num_children);
+	free(bounds);
+
+	result.transform = transform_identity();
+	result.version = 1;
+	return result;
+}
+
+void gjk_compound_free(GJK_Compound *compound){
+	for(i32 i = 0; i < compound->num_children; i += 1)
+		free(compound->children[i].world.points);
+	free(compound->children);
+	gjk_bvh_free(&compound->bvh);
+	compound->children = NULL;
+	compound->num_children = 0;
+}
+
+void gjk_compound_set_transform(GJK_Compound *compound, const Transform &transform){
+	compound->transform = transform;
+	compound->version += 1;
+}
+
+static
+GJK_Polygon *gjk_compound_child_world(GJK_Compound *compound, i32 index){
+	GJK_CompoundChild *child = &compound->children[index];
+	if(child->world_version != compound->version){
+		Transform t = compound->transform * child->transform;
+		// NOTE: `local` may be a strided or indexed view but the world
+		// points are always packed.
+		if(gjk_polygon_is_packed(&child->local)){
+			transform_points(t, child->local.points,
+				child->world.points, child->local.num_points);
+		}else{
+			for(i32 i = 0; i < child->local.num_points; i += 1)
+				child->world.points[i] = transform_point(t, gjk_polygon_point(&child->local, i));
+		}
+		child->world_version = compound->version;
+	}
+	return &child->world;
+}
+
+// NOTE: World points of quantized children are dequantized so their
+// error is added to the margin instead, like `gjk_body_error` does for
+// world bodies.
+static INLINE
+f32 gjk_compound_child_error(GJK_Compound *compound, i32 index){
+	return v3_norm(gjk_polygon_error(&compound->children[index].local));
+}
+
+void gjk_compound_update_children(GJK_Compound *compound){
+	for(i32 i = 0; i < compound->num_children; i += 1)
+		gjk_compound_child_world(compound, i);
+}
+
+static INLINE
+void gjk_compound_add_result(GJK_Polygon *p1, GJK_Polygon *p2,
+		i32 child1, i32 child2, f32 margin,
+		GJK_CompoundResult *results, i32 *num_results){
+	GJK_Result result = gjk(p1, p2);
+	if(result.overlap || result.distance <= margin){
+		GJK_CompoundResult *out = &results[*num_results];
+		out->child1 = child1;
+		out->child2 = child2;
+		out->result = result;
+		*num_results += 1;
+	}
+}
+
+i32 gjk_compound_query(GJK_Compound *compound, GJK_Polygon *p, f32 margin,
+		GJK_CompoundResult *results, i32 max_results){
+	// NOTE: Bring the bounds of `p` into compound space once instead of
+	// moving every node into world space.
+	GJK_BoxTransform to_local = make_box_transform(transform_inverse(compound->transform));
+	AABB world_bounds = gjk_points_bounds(transform_identity(), p);
+	AABB query = gjk_box_expand(gjk_box_transform(to_local, world_bounds), margin);
+
+	GJK_BVHNode *nodes = compound->bvh.nodes;
+	i32 *indices = compound->bvh.indices;
+	i32 stack[GJK_BVH_MAX_DEPTH + 1];
+	i32 stack_size = 0;
+	i32 num_results = 0;
+	stack[stack_size++] = 0;
+	while(stack_size > 0 && num_results < max_results){
+		GJK_BVHNode *node = &nodes[stack[--stack_size]];
+		if(!aabb_overlap(node->bounds, query))
+			continue;
+
+		if(node->count == 0){
+			ASSERT((stack_size + 2) <= (i32)NARRAY(stack));
+			stack[stack_size++] = node->first + 1;
+			stack[stack_size++] = node->first;
+			continue;
+		}
+
+		for(i32 i = 0; i < node->count && num_results < max_results; i += 1){
+			i32 child = indices[node->first + i];
+			if(node->count > 1 && !aabb_overlap(compound->children[child].bounds, query))
+				continue;
+			gjk_compound_add_result(gjk_compound_child_world(compound, child), p,
+				child, -1, margin + gjk_compound_child_error(compound, child),
+				results, &num_results);
+		}
+	}
+	return num_results;
+}
+
+static INLINE
+f32 gjk_box_size(const AABB &box){
+	Vector3 extent = box.max - box.min;
+	return extent.x + extent.y + extent.z;
+}
+
+i32 gjk_compound_query(GJK_Compound *c1, GJK_Compound *c2, f32 margin,
+		GJK_CompoundResult *results, i32 max_results){
+	// NOTE: The traversal is done in the space of `c1` and nodes of `c2`
+	// are moved into it as they're visited.
+	GJK_BoxTransform c2_to_c1 = make_box_transform(
+		transform_inverse(c1->transform) * c2->transform);
+
+	GJK_BVHNode *nodes1 = c1->bvh.nodes;
+	GJK_BVHNode *nodes2 = c2->bvh.nodes;
+	i32 stack[2 * GJK_BVH_MAX_DEPTH + 2][2];
+	i32 stack_size = 0;
+	i32 num_results = 0;
+	stack[stack_size][0] = 0;
+	stack[stack_size][1] = 0;
+	stack_size += 1;
+	while(stack_size > 0 && num_results < max_results){
+		stack_size -= 1;
+		GJK_BVHNode *node1 = &nodes1[stack[stack_size][0]];
+		GJK_BVHNode *node2 = &nodes2[stack[stack_size][1]];
+		AABB bounds1 = gjk_box_expand(node1->bounds, margin);
+		AABB bounds2 = gjk_box_transform(c2_to_c1, node2->bounds);
+		if(!aabb_overlap(bounds1, bounds2))
+			continue;
+
+		// NOTE: Descend into the larger node first so both trees are
+		// refined at about the same rate.
+		bool leaf1 = node1->count > 0;
+		bool leaf2 = node2->count > 0;
+		if(!leaf1 && (leaf2 || gjk_box_size(bounds1) >= gjk_box_size(bounds2))){
+			ASSERT((stack_size + 2) <= (i32)NARRAY(stack));
+			for(i32 i = 1; i >= 0; i -= 1){
+				stack[stack_size][0] = node1->first + i;
+				stack[stack_size][1] = (i32)(node2 - nodes2);
+				stack_size += 1;
+			}
+			continue;
+		}
+
+		if(!leaf2){
+			ASSERT((stack_size + 2) <= (i32)NARRAY(stack));
+			for(i32 i = 1; i >= 0; i -= 1){
+				stack[stack_size][0] = (i32)(node1 - nodes1);
+				stack[stack_size][1] = node2->first + i;
+				stack_size += 1;
+			}
+			continue;
+		}
+
+		for(i32 i = 0; i < node1->count; i += 1){
+			i32 child1 = c1->bvh.indices[node1->first + i];
+			AABB child_bounds1 = gjk_box_expand(c1->children[child1].bounds, margin);
+			for(i32 j = 0; j < node2->count && num_results < max_results; j += 1){
+				i32 child2 = c2->bvh.indices[node2->first + j];
+				AABB child_bounds2 = gjk_box_transform(c2_to_c1, c2->children[child2].bounds);
+				if(!aabb_overlap(child_bounds1, child_bounds2))
+					continue;
+				f32 pair_margin = margin
+					+ gjk_compound_child_error(c1, child1)
+					+ gjk_compound_child_error(c2, child2);
+				gjk_compound_add_result(
+					gjk_compound_child_world(c1, child1),
+					gjk_compound_child_world(c2, child2),
+					child1, child2, pair_margin, results, &num_results);
+			}
+		}
+	}
+	return num_results;
+}
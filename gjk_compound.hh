@@ -0,0 +1,63 @@
+#ifndef GJK_GJK_COMPOUND_HH_
+#define GJK_GJK_COMPOUND_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+#include "gjk_bvh.hh"
+
+// NOTE: A compound shape is a set of convex children, each with its
+// own transform relative to the compound, and a static BVH over the
+// children bounds in compound space. Queries only run GJK on children
+// whose bounds overlap the other shape.
+//
+//	GJK works on world space points so each child keeps a copy of its
+// points in world space. They're only updated when a query touches the
+// child after `gjk_compound_set_transform` which means queries against
+// the same compound must not run in parallel. Call
+// `gjk_compound_update_children` first if they need to.
+struct GJK_CompoundChild{
+	GJK_Polygon local;
+	Transform transform;
+	AABB bounds;
+
+	GJK_Polygon world;
+	u32 world_version;
+};
+
+struct GJK_Compound{
+	i32 num_children;
+	GJK_CompoundChild *children;
+	GJK_BVH bvh;
+
+	Transform transform;
+	u32 version;
+};
+
+// NOTE: `child2` is -1 when the other shape is a single polygon.
+struct GJK_CompoundResult{
+	i32 child1;
+	i32 child2;
+	GJK_Result result;
+};
+
+// NOTE: The children points are referenced, not copied, and must be in
+// the child's local space.
+GJK_Compound gjk_compound_create(i32 num_children,
+		GJK_Polygon *children, Transform *child_transforms);
+void gjk_compound_free(GJK_Compound *compound);
+void gjk_compound_set_transform(GJK_Compound *compound, const Transform &transform);
+void gjk_compound_update_children(GJK_Compound *compound);
+
+// NOTE: Both run GJK on every child pair whose bounds are within `margin`
+// and write the ones that overlap or are closer than `margin` into
+// `results`. They return the number of results written which is at most
+// `max_results`. `p` must be in world space. Quantized children are
+// tested with their world points so their error is added to `margin`,
+// which keeps the results conservative.
+i32 gjk_compound_query(GJK_Compound *compound, GJK_Polygon *p, f32 margin,
+		GJK_CompoundResult *results, i32 max_results);
+i32 gjk_compound_query(GJK_Compound *c1, GJK_Compound *c2, f32 margin,
+		GJK_CompoundResult *results, i32 max_results);
+
+#endif //GJK_GJK_COMPOUND_HH_
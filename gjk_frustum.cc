@@ -0,0 +1,147 @@
+#include "gjk_frustum.hh"
+
+#define GJK_FRUSTUM_GRAIN 256
+
+// NOTE: Plane through `a`, `b` and `c` with its normal facing `inside`.
+static
+void gjk_frustum_plane(GJK_Frustum *frustum, i32 plane,
+		Vector3 a, Vector3 b, Vector3 c, Vector3 inside){
+	Vector3 normal = v3_normalize(v3_cross(b - a, c - a));
+	f32 offset = -v3_dot(normal, a);
+	if((v3_dot(normal, inside) + offset) < 0.0f){
+		normal = -normal;
+		offset = -offset;
+	}
+	frustum->normals[plane] = normal;
+	frustum->offsets[plane] = offset;
+}
+
+GJK_Frustum make_gjk_frustum(Vector3 position, Vector3 direction, Vector3 up,
+		f32 aspect_ratio, f32 yfov, f32 znear, f32 zfar){
+	ASSERT(znear > 0.0f && zfar > znear);
+	direction = v3_normalize(direction);
+	Vector3 right = v3_normalize(v3_cross(direction, up));
+	up = v3_cross(right, direction);
+
+	GJK_Frustum result;
+	f32 aux = tanf(0.5f * yfov);
+	f32 distances[2] = { znear, zfar };
+	for(i32 i = 0; i < 8; i += 1){
+		f32 distance = distances[(i >> 2) & 1];
+		f32 half_h = distance * aux;
+		f32 half_w = half_h * aspect_ratio;
+		f32 x = (i & 1) ? half_w : -half_w;
+		f32 y = (i & 2) ? half_h : -half_h;
+		result.corners[i] = position + distance * direction + x * right + y * up;
+	}
+
+	Vector3 *c = result.corners;
+	Vector3 center = 0.125f * (c[0] + c[1] + c[2] + c[3] + c[4] + c[5] + c[6] + c[7]);
+	gjk_frustum_plane(&result, GJK_FRUSTUM_NEAR, c[0], c[1], c[2], center);
+	gjk_frustum_plane(&result, GJK_FRUSTUM_FAR, c[4], c[5], c[6], center);
+	gjk_frustum_plane(&result, GJK_FRUSTUM_LEFT, c[0], c[2], c[4], center);
+	gjk_frustum_plane(&result, GJK_FRUSTUM_RIGHT, c[1], c[3], c[5], center);
+	gjk_frustum_plane(&result, GJK_FRUSTUM_BOTTOM, c[0], c[1], c[4], center);
+	gjk_frustum_plane(&result, GJK_FRUSTUM_TOP, c[2], c[3], c[6], center);
+
+	result.bounds = make_aabb(c[0], c[0]);
+	for(i32 i = 1; i < 8; i += 1)
+		result.bounds = aabb_union(result.bounds, make_aabb(c[i], c[i]));
+	return result;
+}
+
+// ----------------------------------------------------------------
+// Culling
+// ----------------------------------------------------------------
+#define GJK_FRUSTUM_OUTSIDE 0
+#define GJK_FRUSTUM_INSIDE 1
+#define GJK_FRUSTUM_CROSSING 2
+
+static INLINE
+i32 gjk_frustum_classify(const GJK_Frustum *frustum, const AABB &box){
+	if(box.min.x > frustum->bounds.max.x || box.max.x < frustum->bounds.min.x
+	|| box.min.y > frustum->bounds.max.y || box.max.y < frustum->bounds.min.y
+	|| box.min.z > frustum->bounds.max.z || box.max.z < frustum->bounds.min.z)
+		return GJK_FRUSTUM_OUTSIDE;
+
+	Vector3 center = 0.5f * (box.min + box.max);
+	Vector3 extent = 0.5f * (box.max - box.min);
+	i32 result = GJK_FRUSTUM_INSIDE;
+	for(i32 i = 0; i < 6; i += 1){
+		Vector3 n = frustum->normals[i];
+		f32 distance = v3_dot(n, center) + frustum->offsets[i];
+		f32 radius = extent.x * f32_abs(n.x)
+			+ extent.y * f32_abs(n.y)
+			+ extent.z * f32_abs(n.z);
+		if(distance < -radius)
+			return GJK_FRUSTUM_OUTSIDE;
+		if(distance < radius)
+			result = GJK_FRUSTUM_CROSSING;
+	}
+	return result;
+}
+
+struct GJK_FrustumCull{
+	GJK_Frustum *frustum;
+	GJK_Polygon *polygons;
+	const AABB *bounds;
+	bool *visible;
+	Vector3 *separating_axes;
+	GJK_FrustumStats stats[JOB_MAX_WORKERS];
+};
+
+static
+void gjk_frustum_cull_job(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_FrustumCull *cull = (GJK_FrustumCull*)arg;
+	GJK_Polygon frustum_polygon = gjk_frustum_polygon(cull->frustum);
+	GJK_FrustumStats stats = cull->stats[worker];
+	for(i32 i = begin; i < end; i += 1){
+		i32 side = gjk_frustum_classify(cull->frustum, cull->bounds[i]);
+		if(side == GJK_FRUSTUM_OUTSIDE){
+			cull->visible[i] = false;
+			stats.num_culled += 1;
+		}else if(side == GJK_FRUSTUM_INSIDE){
+			cull->visible[i] = true;
+			stats.num_inside += 1;
+		}else{
+			Vector3 *axis = cull->separating_axes != NULL
+				? &cull->separating_axes[i] : NULL;
+			cull->visible[i] = gjk_collision_test(&frustum_polygon,
+				&cull->polygons[i], axis);
+			stats.num_exact += 1;
+		}
+	}
+	cull->stats[worker] = stats;
+}
+
+i32 gjk_frustum_cull(JobSystem *jobs, GJK_Frustum *frustum,
+		GJK_Polygon *polygons, const AABB *bounds, i32 num_polygons,
+		bool *visible, Vector3 *separating_axes, GJK_FrustumStats *stats){
+	GJK_FrustumCull cull = {};
+	cull.frustum = frustum;
+	cull.polygons = polygons;
+	cull.bounds = bounds;
+	cull.visible = visible;
+	cull.separating_axes = separating_axes;
+
+	JobCounter counter = {};
+	job_parallel_for(jobs, num_polygons, GJK_FRUSTUM_GRAIN,
+		gjk_frustum_cull_job, &cull, &counter, NULL);
+	job_wait(jobs, &counter);
+
+	if(stats != NULL){
+		memset(stats, 0, sizeof(GJK_FrustumStats));
+		for(i32 i = 0; i < job_system_num_workers(jobs); i += 1){
+			stats->num_culled += cull.stats[i].num_culled;
+			stats->num_inside += cull.stats[i].num_inside;
+			stats->num_exact += cull.stats[i].num_exact;
+		}
+	}
+
+	i32 num_visible = 0;
+	for(i32 i = 0; i < num_polygons; i += 1){
+		if(visible[i])
+			num_visible += 1;
+	}
+	return num_visible;
+}
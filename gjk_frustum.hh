@@ -0,0 +1,64 @@
+#ifndef GJK_GJK_FRUSTUM_HH_
+#define GJK_GJK_FRUSTUM_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+#include "jobs.hh"
+
+// NOTE: A view frustum as a convex polygon (its 8 corners) and its 6
+// planes. The parameters are the same as `mat4_perspective` and the
+// camera basis used to build the view matrix (`right` is the cross
+// product of `direction` and `up`).
+//
+//	Corner `i` is on the right side if bit 0 is set, on the top side if
+// bit 1 is set and on the far plane if bit 2 is set. Plane normals
+// point inwards so a point `p` is inside if `dot(normal, p) + offset`
+// is not negative for every plane.
+#define GJK_FRUSTUM_NEAR 0
+#define GJK_FRUSTUM_FAR 1
+#define GJK_FRUSTUM_LEFT 2
+#define GJK_FRUSTUM_RIGHT 3
+#define GJK_FRUSTUM_BOTTOM 4
+#define GJK_FRUSTUM_TOP 5
+
+struct GJK_Frustum{
+	Vector3 corners[8];
+	Vector3 normals[6];
+	f32 offsets[6];
+	AABB bounds;
+};
+
+GJK_Frustum make_gjk_frustum(Vector3 position, Vector3 direction, Vector3 up,
+		f32 aspect_ratio, f32 yfov, f32 znear, f32 zfar);
+
+// NOTE: The polygon references `frustum->corners` so the frustum must
+// not move while it's in use.
+static INLINE
+GJK_Polygon gjk_frustum_polygon(GJK_Frustum *frustum){
+	return make_gjk_polygon(frustum->corners, NARRAY(frustum->corners));
+}
+
+// NOTE: Sets `visible[i]` for each polygon and returns how many are
+// visible. Polygons must be in world space and `bounds` are their
+// AABBs. Each AABB is first tested against the frustum planes: it's
+// culled if it's fully outside one plane and visible if it's fully
+// inside all of them. Only the ones crossing a plane run the exact
+// `gjk_collision_test` against the frustum polygon, since a box can
+// cross several planes near a corner without touching the frustum.
+//
+//	`separating_axes` may be NULL. Otherwise it holds one cached axis
+// per polygon (see `gjk_collision_test`) which speeds up the exact test
+// from one frame to the next. `jobs` may be NULL to run on the calling
+// thread.
+struct GJK_FrustumStats{
+	i32 num_culled;		// resolved by a plane
+	i32 num_inside;		// resolved by being inside all planes
+	i32 num_exact;		// resolved by gjk
+};
+
+i32 gjk_frustum_cull(JobSystem *jobs, GJK_Frustum *frustum,
+		GJK_Polygon *polygons, const AABB *bounds, i32 num_polygons,
+		bool *visible, Vector3 *separating_axes, GJK_FrustumStats *stats);
+
+#endif //GJK_GJK_FRUSTUM_HH_
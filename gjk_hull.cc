@@ -0,0 +1,589 @@
+#include "gjk_hull.hh"
+
+// NOTE: Points closer than this to a face plane (relative to the size
+// of the point cloud) are considered to be on it.
+#define GJK_HULL_EPSILON (1.0e-5f)
+
+struct GJK_HullFace{
+	u32 v[3];
+	// NOTE: `neighbor[e]` is the face across edge v[e] -> v[e + 1].
+	i32 neighbor[3];
+	Vector3d normal;
+	f64 offset;
+	bool alive;
+	i32 visit;
+	// NOTE: Outside points assigned to this face, linked through
+	// `next_conflict`. -1 ends the list.
+	i32 conflict_head;
+};
+
+struct GJK_HullBuilder{
+	const Vector3 *points;
+	i32 num_points;
+	i32 *next_conflict;
+	f32 epsilon;
+
+	i32 num_faces;
+	i32 max_faces;
+	GJK_HullFace *faces;
+};
+
+// NOTE: Planes are kept in double precision. Faces added close to the
+// plane of their neighbours are thin slivers and their normals are way
+// off in single precision, which ends up dropping points that are
+// outside the hull.
+static INLINE
+f32 gjk_hull_face_distance(GJK_HullFace *face, const Vector3 &p){
+	return (f32)(v3d_dot(face->normal, make_v3d(p)) - face->offset);
+}
+
+static
+i32 gjk_hull_add_face(GJK_HullBuilder *builder, u32 a, u32 b, u32 c){
+	if(builder->num_faces >= builder->max_faces){
+		builder->max_faces *= 2;
+		builder->faces = (GJK_HullFace*)realloc(builder->faces,
+			sizeof(GJK_HullFace) * builder->max_faces);
+		ASSERT(builder->faces != NULL);
+	}
+
+	const Vector3 *points = builder->points;
+	i32 index = builder->num_faces++;
+	GJK_HullFace *face = &builder->faces[index];
+	face->v[0] = a;
+	face->v[1] = b;
+	face->v[2] = c;
+	Vector3d pa = make_v3d(points[a]);
+	Vector3d normal = v3d_cross(make_v3d(points[b]) - pa, make_v3d(points[c]) - pa);
+	f64 norm = v3d_norm(normal);
+	face->normal = norm > 0.0 ? (1.0 / norm) * normal : make_v3d(0.0, 0.0, 0.0);
+	face->offset = v3d_dot(face->normal, pa);
+	face->neighbor[0] = -1;
+	face->neighbor[1] = -1;
+	face->neighbor[2] = -1;
+	face->alive = true;
+	face->visit = -1;
+	face->conflict_head = -1;
+	return index;
+}
+
+// NOTE: Adds the face wound so that `inside` is behind it.
+static
+void gjk_hull_add_face_oriented(GJK_HullBuilder *builder,
+		u32 a, u32 b, u32 c, const Vector3 &inside){
+	i32 index = gjk_hull_add_face(builder, a, b, c);
+	GJK_HullFace *face = &builder->faces[index];
+	if(gjk_hull_face_distance(face, inside) > 0.0f){
+		builder->num_faces -= 1;
+		gjk_hull_add_face(builder, a, c, b);
+	}
+}
+
+// NOTE: Assigns the point to the face in [first_face, last_face) it is
+// the farthest in front of. Points that aren't in front of any of them
+// are inside the hull and are dropped.
+static
+void gjk_hull_assign(GJK_HullBuilder *builder, i32 point, i32 first_face, i32 last_face){
+	i32 best_face = -1;
+	f32 best_dist = builder->epsilon;
+	for(i32 i = first_face; i < last_face; i += 1){
+		GJK_HullFace *face = &builder->faces[i];
+		if(!face->alive)
+			continue;
+		f32 dist = gjk_hull_face_distance(face, builder->points[point]);
+		if(dist > best_dist){
+			best_dist = dist;
+			best_face = i;
+		}
+	}
+
+	if(best_face != -1){
+		builder->next_conflict[point] = builder->faces[best_face].conflict_head;
+		builder->faces[best_face].conflict_head = point;
+	}
+}
+
+struct GJK_HullHorizonEdge{
+	u32 a;
+	u32 b;
+	i32 outside;
+};
+
+// NOTE: Links the unlinked edges of faces in [first_face, last_face)
+// to each other by matching reversed edges.
+static
+void gjk_hull_link_faces(GJK_HullBuilder *builder, i32 first_face, i32 last_face){
+	for(i32 i = first_face; i < last_face; i += 1)
+	for(i32 e = 0; e < 3; e += 1){
+		GJK_HullFace *f = &builder->faces[i];
+		if(f->neighbor[e] != -1)
+			continue;
+		u32 a = f->v[e];
+		u32 b = f->v[(e + 1) % 3];
+		for(i32 j = first_face; j < last_face; j += 1){
+			GJK_HullFace *g = &builder->faces[j];
+			for(i32 k = 0; k < 3; k += 1){
+				if(g->v[k] == b && g->v[(k + 1) % 3] == a){
+					f->neighbor[e] = j;
+					g->neighbor[k] = i;
+				}
+			}
+		}
+	}
+}
+
+static
+bool gjk_hull_initial_tetrahedron(GJK_HullBuilder *builder, u32 *tetra){
+	const Vector3 *points = builder->points;
+	i32 num_points = builder->num_points;
+
+	// NOTE: Use the pair of extreme points along the coordinate axes
+	// that are the farthest apart.
+	i32 extremes[6] = {0, 0, 0, 0, 0, 0};
+	for(i32 i = 1; i < num_points; i += 1){
+		for(i32 axis = 0; axis < 3; axis += 1){
+			if(v3_axis(points[i], axis) < v3_axis(points[extremes[axis * 2 + 0]], axis))
+				extremes[axis * 2 + 0] = i;
+			if(v3_axis(points[i], axis) > v3_axis(points[extremes[axis * 2 + 1]], axis))
+				extremes[axis * 2 + 1] = i;
+		}
+	}
+
+	f32 best = -1.0f;
+	for(i32 axis = 0; axis < 3; axis += 1){
+		f32 dist2 = v3_norm2(points[extremes[axis * 2 + 1]] - points[extremes[axis * 2 + 0]]);
+		if(dist2 > best){
+			best = dist2;
+			tetra[0] = (u32)extremes[axis * 2 + 0];
+			tetra[1] = (u32)extremes[axis * 2 + 1];
+		}
+	}
+
+	f32 scale = sqrtf(best);
+	builder->epsilon = GJK_HULL_EPSILON * (scale > 1.0f ? scale : 1.0f);
+	if(scale <= builder->epsilon)
+		return false;
+
+	Vector3 a = points[tetra[0]];
+	Vector3 ab = v3_normalize(points[tetra[1]] - a);
+	best = -1.0f;
+	for(i32 i = 0; i < num_points; i += 1){
+		Vector3 ap = points[i] - a;
+		f32 dist2 = v3_norm2(ap - ab * v3_dot(ap, ab));
+		if(dist2 > best){
+			best = dist2;
+			tetra[2] = (u32)i;
+		}
+	}
+	if(sqrtf(best) <= builder->epsilon)
+		return false;
+
+	Vector3 normal = v3_normalize(v3_cross(points[tetra[1]] - a, points[tetra[2]] - a));
+	best = -1.0f;
+	for(i32 i = 0; i < num_points; i += 1){
+		f32 dist = f32_abs(v3_dot(points[i] - a, normal));
+		if(dist > best){
+			best = dist;
+			tetra[3] = (u32)i;
+		}
+	}
+	return best > builder->epsilon;
+}
+
+bool gjk_hull_build(const Vector3 *points, i32 num_points, GJK_Hull *hull){
+	memset(hull, 0, sizeof(GJK_Hull));
+	if(num_points < 4)
+		return false;
+
+	GJK_HullBuilder builder;
+	builder.points = points;
+	builder.num_points = num_points;
+	builder.num_faces = 0;
+	builder.max_faces = 64;
+	builder.faces = (GJK_HullFace*)malloc(sizeof(GJK_HullFace) * builder.max_faces);
+	builder.next_conflict = (i32*)malloc(sizeof(i32) * num_points);
+	ASSERT(builder.faces != NULL && builder.next_conflict != NULL);
+
+	u32 tetra[4];
+	if(!gjk_hull_initial_tetrahedron(&builder, tetra)){
+		free(builder.faces);
+		free(builder.next_conflict);
+		return false;
+	}
+
+	Vector3 inside = (points[tetra[0]] + points[tetra[1]]
+		+ points[tetra[2]] + points[tetra[3]]) * 0.25f;
+	gjk_hull_add_face_oriented(&builder, tetra[0], tetra[1], tetra[2], inside);
+	gjk_hull_add_face_oriented(&builder, tetra[0], tetra[1], tetra[3], inside);
+	gjk_hull_add_face_oriented(&builder, tetra[0], tetra[2], tetra[3], inside);
+	gjk_hull_add_face_oriented(&builder, tetra[1], tetra[2], tetra[3], inside);
+	for(i32 i = 0; i < num_points; i += 1){
+		builder.next_conflict[i] = -1;
+		if((u32)i != tetra[0] && (u32)i != tetra[1]
+		&& (u32)i != tetra[2] && (u32)i != tetra[3])
+			gjk_hull_assign(&builder, i, 0, builder.num_faces);
+	}
+
+	// NOTE: Link the faces of the tetrahedron. It's done the same way
+	// as for new faces below, matching the reversed edge.
+	gjk_hull_link_faces(&builder, 0, builder.num_faces);
+
+	i32 max_visible = 64;
+	i32 *visible = (i32*)malloc(sizeof(i32) * max_visible);
+	i32 max_horizon = 64;
+	GJK_HullHorizonEdge *horizon = (GJK_HullHorizonEdge*)malloc(
+		sizeof(GJK_HullHorizonEdge) * max_horizon);
+	ASSERT(visible != NULL && horizon != NULL);
+	for(i32 current = 0; current < builder.num_faces; current += 1){
+		GJK_HullFace *face = &builder.faces[current];
+		if(!face->alive || face->conflict_head == -1)
+			continue;
+
+		// NOTE: The next point added is the farthest one in front of
+		// this face.
+		i32 eye = face->conflict_head;
+		f32 eye_dist = gjk_hull_face_distance(face, points[eye]);
+		for(i32 p = builder.next_conflict[eye]; p != -1; p = builder.next_conflict[p]){
+			f32 dist = gjk_hull_face_distance(face, points[p]);
+			if(dist > eye_dist){
+				eye_dist = dist;
+				eye = p;
+			}
+		}
+
+		// NOTE: Flood the faces visible from `eye` starting at the
+		// current face. Only walking over neighbours keeps the visible
+		// region connected, which a plain scan over all faces doesn't
+		// guarantee with nearly coplanar faces. Every edge crossed into
+		// a face that is not visible is part of the horizon.
+		i32 num_visible = 1;
+		i32 num_horizon = 0;
+		visible[0] = current;
+		face->visit = current;
+		for(i32 i = 0; i < num_visible; i += 1)
+		for(i32 e = 0; e < 3; e += 1){
+			GJK_HullFace *f = &builder.faces[visible[i]];
+			i32 n = f->neighbor[e];
+			ASSERT(n != -1);
+			GJK_HullFace *g = &builder.faces[n];
+			if(g->visit == current)
+				continue;
+
+			if(gjk_hull_face_distance(g, points[eye]) > builder.epsilon){
+				if(num_visible >= max_visible){
+					max_visible *= 2;
+					visible = (i32*)realloc(visible, sizeof(i32) * max_visible);
+					ASSERT(visible != NULL);
+				}
+				g->visit = current;
+				visible[num_visible++] = n;
+			}else{
+				if(num_horizon >= max_horizon){
+					max_horizon *= 2;
+					horizon = (GJK_HullHorizonEdge*)realloc(horizon,
+						sizeof(GJK_HullHorizonEdge) * max_horizon);
+					ASSERT(horizon != NULL);
+				}
+				horizon[num_horizon].a = f->v[e];
+				horizon[num_horizon].b = f->v[(e + 1) % 3];
+				horizon[num_horizon].outside = n;
+				num_horizon += 1;
+			}
+		}
+
+		for(i32 i = 0; i < num_visible; i += 1)
+			builder.faces[visible[i]].alive = false;
+
+		i32 first_new = builder.num_faces;
+		for(i32 i = 0; i < num_horizon; i += 1){
+			i32 index = gjk_hull_add_face(&builder,
+				horizon[i].a, horizon[i].b, (u32)eye);
+			GJK_HullFace *outside = &builder.faces[horizon[i].outside];
+			builder.faces[index].neighbor[0] = horizon[i].outside;
+			for(i32 k = 0; k < 3; k += 1){
+				if(outside->v[k] == horizon[i].b && outside->v[(k + 1) % 3] == horizon[i].a)
+					outside->neighbor[k] = index;
+			}
+		}
+		gjk_hull_link_faces(&builder, first_new, builder.num_faces);
+
+		for(i32 i = 0; i < num_visible; i += 1){
+			GJK_HullFace *f = &builder.faces[visible[i]];
+			i32 p = f->conflict_head;
+			f->conflict_head = -1;
+			while(p != -1){
+				i32 next = builder.next_conflict[p];
+				if(p != eye)
+					gjk_hull_assign(&builder, p, first_new, builder.num_faces);
+				p = next;
+			}
+		}
+	}
+	free(visible);
+	free(horizon);
+	free(builder.next_conflict);
+
+	// NOTE: Keep only the points used by the faces that survived.
+	u32 *remap = (u32*)malloc(sizeof(u32) * num_points);
+	ASSERT(remap != NULL);
+	for(i32 i = 0; i < num_points; i += 1)
+		remap[i] = 0xFFFFFFFF;
+
+	i32 num_faces = 0;
+	i32 num_hull_points = 0;
+	for(i32 i = 0; i < builder.num_faces; i += 1){
+		GJK_HullFace *f = &builder.faces[i];
+		if(!f->alive)
+			continue;
+		num_faces += 1;
+		for(i32 k = 0; k < 3; k += 1){
+			if(remap[f->v[k]] == 0xFFFFFFFF)
+				remap[f->v[k]] = (u32)num_hull_points++;
+		}
+	}
+
+	hull->num_points = num_hull_points;
+	hull->points = (Vector3*)malloc(sizeof(Vector3) * num_hull_points);
+	hull->num_faces = num_faces;
+	hull->faces = (u32*)malloc(sizeof(u32) * 3 * num_faces);
+	hull->adjacency_offsets = (u32*)calloc(num_hull_points + 1, sizeof(u32));
+	hull->adjacency = (u32*)malloc(sizeof(u32) * 3 * num_faces);
+	ASSERT(hull->points != NULL && hull->faces != NULL
+		&& hull->adjacency_offsets != NULL && hull->adjacency != NULL);
+	for(i32 i = 0; i < num_points; i += 1){
+		if(remap[i] != 0xFFFFFFFF)
+			hull->points[remap[i]] = points[i];
+	}
+
+	u32 *out = hull->faces;
+	for(i32 i = 0; i < builder.num_faces; i += 1){
+		GJK_HullFace *f = &builder.faces[i];
+		if(!f->alive)
+			continue;
+		for(i32 k = 0; k < 3; k += 1){
+			*out++ = remap[f->v[k]];
+			hull->adjacency_offsets[remap[f->v[k]] + 1] += 1;
+		}
+	}
+	free(remap);
+	free(builder.faces);
+
+	// NOTE: Every edge of a closed triangle mesh shows up once in each
+	// direction so the neighbours of a vertex are the ends of the
+	// directed edges that start at it.
+	for(i32 i = 0; i < num_hull_points; i += 1)
+		hull->adjacency_offsets[i + 1] += hull->adjacency_offsets[i];
+	for(i32 i = 0; i < num_faces; i += 1)
+	for(i32 k = 0; k < 3; k += 1){
+		u32 a = hull->faces[i * 3 + k];
+		u32 b = hull->faces[i * 3 + (k + 1) % 3];
+		hull->adjacency[hull->adjacency_offsets[a]++] = b;
+	}
+	for(i32 i = num_hull_points; i > 0; i -= 1)
+		hull->adjacency_offsets[i] = hull->adjacency_offsets[i - 1];
+	hull->adjacency_offsets[0] = 0;
+	return true;
+}
+
+void gjk_hull_free(GJK_Hull *hull){
+	free(hull->points);
+	free(hull->faces);
+	free(hull->adjacency_offsets);
+	free(hull->adjacency);
+	memset(hull, 0, sizeof(GJK_Hull));
+}
+
+// ----------------------------------------------------------------
+// Minkowski difference
+// ----------------------------------------------------------------
+#define GJK_MINKOWSKI_MAX_ROUNDS 32
+
+// NOTE: Points of the Minkowski difference are identified by the pair of
+// support indices that produced them, packed as (index1 << 32 | index2).
+struct GJK_MinkowskiKeys{
+	i32 num_keys;
+	i32 max_keys;
+	u64 *keys;
+};
+
+// NOTE: One side of the difference. Supports hill climb over the hull of
+// the polygon when it has one, otherwise they scan the polygon.
+struct GJK_MinkowskiShape{
+	GJK_Polygon *polygon;
+	GJK_Hull hull;
+	bool has_hull;
+};
+
+static
+void gjk_minkowski_shape_init(GJK_MinkowskiShape *shape, GJK_Polygon *polygon){
+	shape->polygon = polygon;
+	shape->has_hull = false;
+	memset(&shape->hull, 0, sizeof(GJK_Hull));
+	if(gjk_polygon_is_packed(polygon))
+		shape->has_hull = gjk_hull_build(polygon->points, polygon->num_points, &shape->hull);
+}
+
+static INLINE
+Vector3 gjk_minkowski_shape_point(GJK_MinkowskiShape *shape, i32 index){
+	return shape->has_hull
+		? shape->hull.points[index]
+		: gjk_polygon_point(shape->polygon, index);
+}
+
+static
+i32 gjk_minkowski_shape_support(GJK_MinkowskiShape *shape, Vector3 dir, i32 start){
+	if(!shape->has_hull)
+		return gjk_polygon_support_index(shape->polygon, dir);
+
+	GJK_Hull *hull = &shape->hull;
+	i32 current = start;
+	f32 current_dot = v3_dot(hull->points[current], dir);
+	bool moved = true;
+	while(moved){
+		moved = false;
+		for(u32 i = hull->adjacency_offsets[current]; i < hull->adjacency_offsets[current + 1]; i += 1){
+			i32 next = (i32)hull->adjacency[i];
+			f32 next_dot = v3_dot(hull->points[next], dir);
+			if(next_dot > current_dot){
+				current = next;
+				current_dot = next_dot;
+				moved = true;
+			}
+		}
+	}
+	return current;
+}
+
+static INLINE
+u64 gjk_minkowski_support(GJK_MinkowskiShape *s1, GJK_MinkowskiShape *s2, Vector3 dir, u64 start){
+	u64 index1 = (u64)gjk_minkowski_shape_support(s1, dir, (i32)(start >> 32));
+	u64 index2 = (u64)gjk_minkowski_shape_support(s2, -dir, (i32)(start & 0xFFFFFFFF));
+	return (index1 << 32) | index2;
+}
+
+static INLINE
+Vector3 gjk_minkowski_point(GJK_MinkowskiShape *s1, GJK_MinkowskiShape *s2, u64 key){
+	return gjk_minkowski_shape_point(s1, (i32)(key >> 32))
+		- gjk_minkowski_shape_point(s2, (i32)(key & 0xFFFFFFFF));
+}
+
+static
+int gjk_minkowski_key_compare(const void *a, const void *b){
+	u64 ka = *(const u64*)a;
+	u64 kb = *(const u64*)b;
+	return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+static
+void gjk_minkowski_push(GJK_MinkowskiKeys *set, u64 key){
+	if(set->num_keys >= set->max_keys){
+		set->max_keys *= 2;
+		set->keys = (u64*)realloc(set->keys, sizeof(u64) * set->max_keys);
+		ASSERT(set->keys != NULL);
+	}
+	set->keys[set->num_keys] = key;
+	set->num_keys += 1;
+}
+
+static
+void gjk_minkowski_unique(GJK_MinkowskiKeys *set){
+	if(set->num_keys == 0)
+		return;
+	qsort(set->keys, (usize)set->num_keys, sizeof(u64), gjk_minkowski_key_compare);
+	i32 num_unique = 1;
+	for(i32 i = 1; i < set->num_keys; i += 1){
+		if(set->keys[i] != set->keys[num_unique - 1])
+			set->keys[num_unique++] = set->keys[i];
+	}
+	set->num_keys = num_unique;
+}
+
+bool gjk_minkowski_hull_build(GJK_Polygon *p1, GJK_Polygon *p2,
+		i32 num_directions, GJK_Hull *hull){
+	ASSERT(num_directions >= 4);
+	memset(hull, 0, sizeof(GJK_Hull));
+
+	GJK_MinkowskiShape s1, s2;
+	gjk_minkowski_shape_init(&s1, p1);
+	gjk_minkowski_shape_init(&s2, p2);
+
+	GJK_MinkowskiKeys set;
+	set.num_keys = 0;
+	set.max_keys = num_directions;
+	set.keys = (u64*)malloc(sizeof(u64) * set.max_keys);
+	ASSERT(set.keys != NULL);
+
+	// NOTE: Fibonacci sphere. Directions are spread evenly enough that
+	// every large face of the difference gets a few samples and each one
+	// is close to the previous one so climbing starts from its support.
+	f32 golden_angle = (f32)(CONST_PI * (3.0 - sqrt(5.0)));
+	u64 key = 0;
+	for(i32 i = 0; i < num_directions; i += 1){
+		f32 z = 1.0f - (2.0f * (f32)i + 1.0f) / (f32)num_directions;
+		f32 r = sqrtf(1.0f - z * z);
+		f32 phi = golden_angle * (f32)i;
+		Vector3 dir = make_v3(r * cosf(phi), r * sinf(phi), z);
+		key = gjk_minkowski_support(&s1, &s2, dir, key);
+		gjk_minkowski_push(&set, key);
+	}
+	gjk_minkowski_unique(&set);
+
+	bool result = false;
+	i32 max_points = 0;
+	Vector3 *points = NULL;
+	for(i32 round = 0; round < GJK_MINKOWSKI_MAX_ROUNDS; round += 1){
+		if(set.num_keys > max_points){
+			max_points = set.max_keys;
+			points = (Vector3*)realloc(points, sizeof(Vector3) * max_points);
+			ASSERT(points != NULL);
+		}
+
+		f32 scale = 0.0f;
+		for(i32 i = 0; i < set.num_keys; i += 1){
+			points[i] = gjk_minkowski_point(&s1, &s2, set.keys[i]);
+			for(i32 axis = 0; axis < 3; axis += 1){
+				f32 value = f32_abs(v3_axis(points[i], axis));
+				if(value > scale)
+					scale = value;
+			}
+		}
+
+		gjk_hull_free(hull);
+		result = gjk_hull_build(points, set.num_keys, hull);
+		if(!result)
+			break;
+
+		// NOTE: A face whose support point is in front of it isn't part
+		// of the difference's hull yet. Normals are computed in double
+		// precision for the same reason as in `gjk_hull_add_face`.
+		f64 epsilon = GJK_HULL_EPSILON * (scale > 1.0f ? scale : 1.0f);
+		i32 num_keys = set.num_keys;
+		for(i32 i = 0; i < hull->num_faces; i += 1){
+			Vector3d a = make_v3d(hull->points[hull->faces[i * 3 + 0]]);
+			Vector3d b = make_v3d(hull->points[hull->faces[i * 3 + 1]]);
+			Vector3d c = make_v3d(hull->points[hull->faces[i * 3 + 2]]);
+			Vector3d normal = v3d_cross(b - a, c - a);
+			f64 norm = v3d_norm(normal);
+			if(norm <= 0.0)
+				continue;
+			normal = (1.0 / norm) * normal;
+			Vector3 dir = make_v3((f32)normal.x, (f32)normal.y, (f32)normal.z);
+			u64 support = gjk_minkowski_support(&s1, &s2, dir, key);
+			Vector3d point = make_v3d(gjk_minkowski_point(&s1, &s2, support));
+			if(v3d_dot(point - a, normal) > epsilon)
+				gjk_minkowski_push(&set, support);
+			key = support;
+		}
+		// NOTE: Points may already be in the set when the face is off
+		// only because `gjk_hull_build` tolerates some error, so the set
+		// has to actually grow for another round to make sense.
+		gjk_minkowski_unique(&set);
+		if(set.num_keys == num_keys)
+			break;
+	}
+
+	free(points);
+	free(set.keys);
+	gjk_hull_free(&s1.hull);
+	gjk_hull_free(&s2.hull);
+	return result;
+}
@@ -0,0 +1,47 @@
+#ifndef GJK_GJK_HULL_HH_
+#define GJK_GJK_HULL_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+
+// NOTE: Convex hull of a point cloud (quickhull). `points` only has the
+// points that ended up on the hull and `faces` are triangles (3 indices
+// each, counter clockwise seen from outside) so coplanar faces are
+// split into several triangles.
+//
+//	The neighbours of vertex `i` are `adjacency[adjacency_offsets[i]
+// .. adjacency_offsets[i + 1])`. They're what hill climbing support
+// functions walk over.
+struct GJK_Hull{
+	i32 num_points;
+	Vector3 *points;
+
+	i32 num_faces;
+	u32 *faces;
+
+	u32 *adjacency_offsets;
+	u32 *adjacency;
+};
+
+// NOTE: Returns false if the points are degenerate (all on a plane or
+// a line). The hull owns its arrays and must be freed.
+bool gjk_hull_build(const Vector3 *points, i32 num_points, GJK_Hull *hull);
+void gjk_hull_free(GJK_Hull *hull);
+
+// NOTE: Convex hull of the Minkowski difference `p1 - p2` without going
+// through all n * m pairwise differences. Support points are sampled
+// along `num_directions` directions spread over the sphere, then the
+// hull is refined with the support point along each face normal until
+// every face is a supporting plane, at which point it's exact. It gives
+// up refining after a few rounds. Each round costs one support call per
+// direction or face plus `gjk_hull_build` over the points found.
+bool gjk_minkowski_hull_build(GJK_Polygon *p1, GJK_Polygon *p2,
+		i32 num_directions, GJK_Hull *hull);
+
+static INLINE
+GJK_Polygon gjk_hull_polygon(GJK_Hull *hull){
+	return make_gjk_polygon(hull->points, hull->num_points);
+}
+
+#endif //GJK_GJK_HULL_HH_
@@ -0,0 +1,543 @@
+// NOTE: The manifold is built from the support faces of both polygons
+// along the contact normal. We don't have face information in the
+// polygons so a support face is just the set of vertices that are
+// within GJK_MANIFOLD_FACE_TOLERANCE of the support plane, sorted
+// around their centroid. This works because the polygons are convex.
+
+#include "gjk_manifold.hh"
+
+struct GJK_ClipVertex{
+	Vector3 point;
+	u32 feature_id;
+};
+
+#define GJK_MAX_CLIP_VERTICES (2 * GJK_MANIFOLD_MAX_FACE_POINTS)
+
+// NOTE: Edges with |cross(dir1, dir2)| above ~3 degrees are crossing.
+#define GJK_MANIFOLD_PARALLEL_TOLERANCE2 (0.05f * 0.05f)
+
+static
+i32 gjk_support_face(GJK_Polygon *p, Vector3 dir, i32 *indices){
+	ASSERT(p->num_points > 0);
+	f32 max = v3_dot(gjk_polygon_point(p, 0), dir);
+	for(i32 i = 1; i < p->num_points; i += 1){
+		f32 dot = v3_dot(gjk_polygon_point(p, i), dir);
+		if(dot > max)
+			max = dot;
+	}
+
+	i32 count = 0;
+	f32 min = max - GJK_MANIFOLD_FACE_TOLERANCE;
+	for(i32 i = 0; i < p->num_points && count < GJK_MANIFOLD_MAX_FACE_POINTS; i += 1){
+		if(v3_dot(gjk_polygon_point(p, i), dir) >= min){
+			indices[count] = i;
+			count += 1;
+		}
+	}
+	return count;
+}
+
+static
+void gjk_plane_basis(Vector3 normal, Vector3 *u, Vector3 *v){
+	if(f32_abs(normal.x) > 0.57f)
+		*u = v3_normalize(v3_cross(normal, make_v3(0.0f, 1.0f, 0.0f)));
+	else
+		*u = v3_normalize(v3_cross(normal, make_v3(1.0f, 0.0f, 0.0f)));
+	*v = v3_cross(normal, *u);
+}
+
+// NOTE: Sorts the face vertices counter-clockwise around `normal`.
+static
+void gjk_sort_face(GJK_Polygon *p, Vector3 normal, i32 *indices, i32 count){
+	if(count < 3)
+		return;
+
+	Vector3 centroid = v3_zero;
+	for(i32 i = 0; i < count; i += 1)
+		centroid += gjk_polygon_point(p, indices[i]);
+	centroid = (1.0f / (f32)count) * centroid;
+
+	Vector3 u, v;
+	gjk_plane_basis(normal, &u, &v);
+
+	f32 angles[GJK_MANIFOLD_MAX_FACE_POINTS];
+	for(i32 i = 0; i < count; i += 1){
+		Vector3 d = gjk_polygon_point(p, indices[i]) - centroid;
+		angles[i] = atan2f(v3_dot(d, v), v3_dot(d, u));
+	}
+
+	// NOTE: Faces are small so insertion sort is fine.
+	for(i32 i = 1; i < count; i += 1){
+		f32 angle = angles[i];
+		i32 index = indices[i];
+		i32 j = i - 1;
+		while(j >= 0 && angles[j] > angle){
+			angles[j + 1] = angles[j];
+			indices[j + 1] = indices[j];
+			j -= 1;
+		}
+		angles[j + 1] = angle;
+		indices[j + 1] = index;
+	}
+}
+
+// NOTE: Sutherland-Hodgman against a single plane. Points with
+// dot(plane_normal, point) <= plane_offset are inside. If `closed`
+// is false the input is treated as a polyline.
+static
+i32 gjk_clip(GJK_ClipVertex *in, i32 num_in, bool closed,
+		Vector3 plane_normal, f32 plane_offset, u32 ref_feature,
+		GJK_ClipVertex *out){
+	if(num_in == 0)
+		return 0;
+
+	i32 num_out = 0;
+	i32 start = 0;
+	GJK_ClipVertex prev = in[num_in - 1];
+	if(!closed){
+		prev = in[0];
+		start = 1;
+		if(v3_dot(plane_normal, prev.point) <= plane_offset){
+			out[num_out] = prev;
+			num_out += 1;
+		}
+	}
+
+	f32 prev_dist = v3_dot(plane_normal, prev.point) - plane_offset;
+	for(i32 i = start; i < num_in; i += 1){
+		GJK_ClipVertex cur = in[i];
+		f32 cur_dist = v3_dot(plane_normal, cur.point) - plane_offset;
+		if((prev_dist <= 0.0f) != (cur_dist <= 0.0f)){
+			ASSERT(num_out < GJK_MAX_CLIP_VERTICES);
+			f32 t = prev_dist / (prev_dist - cur_dist);
+			GJK_ClipVertex clipped;
+			clipped.point = prev.point + t * (cur.point - prev.point);
+			clipped.feature_id = (ref_feature << 16) | (prev.feature_id & 0xFFFF);
+			out[num_out] = clipped;
+			num_out += 1;
+		}
+		if(cur_dist <= 0.0f){
+			ASSERT(num_out < GJK_MAX_CLIP_VERTICES);
+			out[num_out] = cur;
+			num_out += 1;
+		}
+		prev = cur;
+		prev_dist = cur_dist;
+	}
+	return num_out;
+}
+
+// NOTE: Keeps the deepest contact, the one farthest from it, and then
+// the two that form the largest triangles on each side of the line
+// between the first two. This preserves most of the contact area.
+static
+void gjk_reduce_contacts(GJK_Contact *contacts, i32 *num_contacts, Vector3 normal){
+	i32 count = *num_contacts;
+	if(count <= GJK_MAX_CONTACTS)
+		return;
+
+	i32 a = 0;
+	for(i32 i = 1; i < count; i += 1){
+		if(contacts[i].separation < contacts[a].separation)
+			a = i;
+	}
+
+	i32 b = a;
+	f32 max_dist2 = -1.0f;
+	for(i32 i = 0; i < count; i += 1){
+		f32 dist2 = v3_norm2(contacts[i].point2 - contacts[a].point2);
+		if(i != a && dist2 > max_dist2){
+			max_dist2 = dist2;
+			b = i;
+		}
+	}
+
+	Vector3 A = contacts[a].point2;
+	Vector3 AB = contacts[b].point2 - A;
+	i32 c = -1;
+	i32 d = -1;
+	f32 max_area = 0.0f;
+	f32 min_area = 0.0f;
+	for(i32 i = 0; i < count; i += 1){
+		if(i == a || i == b)
+			continue;
+		f32 area = v3_dot(v3_cross(AB, contacts[i].point2 - A), normal);
+		if(area > max_area){
+			max_area = area;
+			c = i;
+		}else if(area < min_area){
+			min_area = area;
+			d = i;
+		}
+	}
+
+	GJK_Contact reduced[GJK_MAX_CONTACTS];
+	i32 num_reduced = 0;
+	reduced[num_reduced++] = contacts[a];
+	reduced[num_reduced++] = contacts[b];
+	if(c >= 0) reduced[num_reduced++] = contacts[c];
+	if(d >= 0) reduced[num_reduced++] = contacts[d];
+	for(i32 i = 0; i < num_reduced; i += 1)
+		contacts[i] = reduced[i];
+	*num_contacts = num_reduced;
+}
+
+// NOTE: Closest points between two support features where at least
+// one of them is a vertex or both are edges. This is only used when
+// we don't have a `GJK_Result`.
+static
+void gjk_closest_features(GJK_Polygon *p1, i32 *face1, i32 count1,
+		GJK_Polygon *p2, i32 *face2, i32 count2,
+		Vector3 *closest1, Vector3 *closest2){
+	Vector3 a1 = gjk_polygon_point(p1, face1[0]);
+	Vector3 a2 = gjk_polygon_point(p2, face2[0]);
+	if(count1 == 1 && count2 == 1){
+		*closest1 = a1;
+		*closest2 = a2;
+		return;
+	}
+
+	// NOTE: For a vertex against a face, the face is treated as the
+	// plane it's in. That's correct as long as the vertex projects
+	// inside the face which is the case for support features.
+	if(count1 == 1){
+		Vector3 b2 = gjk_polygon_point(p2, face2[1]);
+		if(count2 == 2){
+			Vector3 d2 = b2 - a2;
+			f32 t = v3_dot(a1 - a2, d2) / v3_norm2(d2);
+			t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+			*closest1 = a1;
+			*closest2 = a2 + t * d2;
+		}else{
+			Vector3 n = v3_normalize(v3_cross(b2 - a2, gjk_polygon_point(p2, face2[2]) - a2));
+			*closest1 = a1;
+			*closest2 = a1 - v3_dot(a1 - a2, n) * n;
+		}
+		return;
+	}
+
+	if(count2 == 1){
+		gjk_closest_features(p2, face2, count2,
+			p1, face1, count1, closest2, closest1);
+		return;
+	}
+
+	// NOTE: Segment against segment. See "Real-Time Collision
+	// Detection" (Ericson) 5.1.9 for the general case. Here we know
+	// the segments are not parallel.
+	ASSERT(count1 == 2 && count2 == 2);
+	Vector3 d1 = gjk_polygon_point(p1, face1[1]) - a1;
+	Vector3 d2 = gjk_polygon_point(p2, face2[1]) - a2;
+	Vector3 r = a1 - a2;
+	f32 a = v3_dot(d1, d1);
+	f32 e = v3_dot(d2, d2);
+	f32 f = v3_dot(d2, r);
+	f32 c = v3_dot(d1, r);
+	f32 b = v3_dot(d1, d2);
+	f32 denom = a * e - b * b;
+	f32 s = (b * f - c * e) / denom;
+	s = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+	f32 t = (b * s + f) / e;
+	if(t < 0.0f){
+		t = 0.0f;
+		s = -c / a;
+	}else if(t > 1.0f){
+		t = 1.0f;
+		s = (b - c) / a;
+	}
+	s = s < 0.0f ? 0.0f : (s > 1.0f ? 1.0f : s);
+	*closest1 = a1 + s * d1;
+	*closest2 = a2 + t * d2;
+}
+
+static
+bool gjk_manifold_build_internal(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 normal, f32 margin, GJK_Result *result,
+		GJK_Manifold *manifold){
+	manifold->normal = normal;
+	manifold->num_contacts = 0;
+
+	i32 face1[GJK_MANIFOLD_MAX_FACE_POINTS];
+	i32 face2[GJK_MANIFOLD_MAX_FACE_POINTS];
+	i32 count1 = gjk_support_face(p1, normal, face1);
+	i32 count2 = gjk_support_face(p2, -normal, face2);
+
+	// NOTE: Vertex against anything and crossing edges give a single
+	// contact. Parallel edges are clipped like faces below.
+	bool single_contact = (count1 == 1 || count2 == 1);
+	if(count1 == 2 && count2 == 2){
+		Vector3 dir1 = v3_normalize(gjk_polygon_point(p1, face1[1]) - gjk_polygon_point(p1, face1[0]));
+		Vector3 dir2 = v3_normalize(gjk_polygon_point(p2, face2[1]) - gjk_polygon_point(p2, face2[0]));
+		single_contact = v3_norm2(v3_cross(dir1, dir2)) > GJK_MANIFOLD_PARALLEL_TOLERANCE2;
+	}
+
+	if(single_contact){
+		GJK_Contact contact;
+		if(result){
+			contact.point1 = result->closest1;
+			contact.point2 = result->closest2;
+		}else{
+			gjk_closest_features(p1, face1, count1,
+				p2, face2, count2, &contact.point1, &contact.point2);
+		}
+		contact.separation = v3_dot(contact.point2 - contact.point1, normal);
+		contact.feature_id = ((u32)(face1[0] & 0xFFFF) << 16) | (u32)(face2[0] & 0xFFFF);
+		if(contact.separation > margin)
+			return false;
+		manifold->contacts[0] = contact;
+		manifold->num_contacts = 1;
+		return true;
+	}
+
+	// NOTE: The face with more vertices is the reference face.
+	bool ref_is_p1 = count1 >= count2;
+	GJK_Polygon *ref = ref_is_p1 ? p1 : p2;
+	GJK_Polygon *inc = ref_is_p1 ? p2 : p1;
+	i32 *ref_face = ref_is_p1 ? face1 : face2;
+	i32 *inc_face = ref_is_p1 ? face2 : face1;
+	i32 ref_count = ref_is_p1 ? count1 : count2;
+	i32 inc_count = ref_is_p1 ? count2 : count1;
+	Vector3 ref_normal = ref_is_p1 ? normal : -normal;
+
+	gjk_sort_face(ref, ref_normal, ref_face, ref_count);
+	gjk_sort_face(inc, -ref_normal, inc_face, inc_count);
+
+	GJK_ClipVertex buffer1[GJK_MAX_CLIP_VERTICES];
+	GJK_ClipVertex buffer2[GJK_MAX_CLIP_VERTICES];
+	GJK_ClipVertex *in = buffer1;
+	GJK_ClipVertex *out = buffer2;
+	i32 num_in = inc_count;
+	for(i32 i = 0; i < inc_count; i += 1){
+		in[i].point = gjk_polygon_point(inc, inc_face[i]);
+		in[i].feature_id = ((u32)GJK_FEATURE_NONE << 16) | (u32)(inc_face[i] & 0xFFFF);
+	}
+
+	bool closed = inc_count >= 3;
+	if(ref_count == 2){
+		// NOTE: The reference "face" is an edge so we only clip
+		// against the planes at both of its ends.
+		Vector3 a = gjk_polygon_point(ref, ref_face[0]);
+		Vector3 b = gjk_polygon_point(ref, ref_face[1]);
+		num_in = gjk_clip(in, num_in, closed, a - b, v3_dot(a - b, a),
+			(u32)ref_face[0] & 0xFFFF, out);
+		GJK_ClipVertex *tmp = in; in = out; out = tmp;
+		num_in = gjk_clip(in, num_in, closed, b - a, v3_dot(b - a, b),
+			(u32)ref_face[1] & 0xFFFF, out);
+		tmp = in; in = out; out = tmp;
+	}else{
+		for(i32 i = 0; i < ref_count; i += 1){
+			Vector3 a = gjk_polygon_point(ref, ref_face[i]);
+			Vector3 b = gjk_polygon_point(ref, ref_face[(i + 1) % ref_count]);
+			Vector3 side = v3_cross(b - a, ref_normal);
+			num_in = gjk_clip(in, num_in, closed, side, v3_dot(side, a),
+				(u32)ref_face[i] & 0xFFFF, out);
+			GJK_ClipVertex *tmp = in; in = out; out = tmp;
+		}
+	}
+
+	// NOTE: Keep only points within `margin` of the reference face.
+	GJK_Contact contacts[GJK_MAX_CLIP_VERTICES];
+	i32 num_contacts = 0;
+	Vector3 ref_point = gjk_polygon_point(ref, ref_face[0]);
+	for(i32 i = 0; i < num_in; i += 1){
+		Vector3 q = in[i].point;
+		f32 sep = v3_dot(q - ref_point, ref_normal);
+		if(sep > margin)
+			continue;
+
+		GJK_Contact contact;
+		if(ref_is_p1){
+			contact.point1 = q - sep * ref_normal;
+			contact.point2 = q;
+		}else{
+			contact.point1 = q;
+			contact.point2 = q - sep * ref_normal;
+		}
+		contact.separation = sep;
+		contact.feature_id = in[i].feature_id;
+		contacts[num_contacts] = contact;
+		num_contacts += 1;
+	}
+
+	gjk_reduce_contacts(contacts, &num_contacts, normal);
+	for(i32 i = 0; i < num_contacts; i += 1)
+		manifold->contacts[i] = contacts[i];
+	manifold->num_contacts = num_contacts;
+	return num_contacts > 0;
+}
+
+bool gjk_manifold_build(GJK_Polygon *p1, GJK_Polygon *p2,
+		GJK_Result *result, f32 margin, GJK_Manifold *manifold){
+	manifold->num_contacts = 0;
+	if(result->overlap)
+		return false;
+
+	Vector3 delta = result->closest2 - result->closest1;
+	if(v3_cmp_zero(delta))
+		return false;
+
+	Vector3 normal = v3_normalize(delta);
+	return gjk_manifold_build_internal(p1, p2, normal, margin, result, manifold);
+}
+
+bool gjk_manifold_build_with_normal(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 normal, f32 margin, GJK_Manifold *manifold){
+	return gjk_manifold_build_internal(p1, p2,
+		v3_normalize(normal), margin, NULL, manifold);
+}
+
+// ----------------------------------------------------------------
+// Persistent Manifolds
+// ----------------------------------------------------------------
+void gjk_persistent_manifold_reset(GJK_PersistentManifold *pm){
+	pm->valid = false;
+	pm->num_points = 0;
+}
+
+bool gjk_persistent_manifold_refresh(GJK_PersistentManifold *pm,
+		const Transform &t1, const Transform &t2){
+	if(!pm->valid)
+		return false;
+
+	Transform relative = transform_inverse(t1) * t2;
+	Vector3 delta = relative.translation - pm->relative.translation;
+	f32 linear_tolerance2 = GJK_PERSISTENT_LINEAR_TOLERANCE
+		* GJK_PERSISTENT_LINEAR_TOLERANCE;
+	if(v3_norm2(delta) > linear_tolerance2)
+		return false;
+
+	// NOTE: q and -q are the same rotation.
+	f32 rotation_delta = 1.0f - fabsf(quat_dot(relative.rotation, pm->relative.rotation));
+	if(rotation_delta > GJK_PERSISTENT_ANGULAR_TOLERANCE)
+		return false;
+
+	// NOTE: Every point is checked before any of them is written so a
+	// failed refresh leaves the manifold as it was for the merge that
+	// follows.
+	Vector3 normal = v3_rotate(pm->local_normal, t1.rotation);
+	Vector3 points1[GJK_MAX_CONTACTS];
+	Vector3 points2[GJK_MAX_CONTACTS];
+	f32 separations[GJK_MAX_CONTACTS];
+	ASSERT(pm->num_points <= GJK_MAX_CONTACTS);
+	for(i32 i = 0; i < pm->num_points; i += 1){
+		GJK_ManifoldPoint *point = &pm->points[i];
+		Vector3 point1 = transform_point(t1, point->local1);
+		Vector3 point2 = transform_point(t2, point->local2);
+		Vector3 diff = point2 - point1;
+		f32 separation = v3_dot(diff, normal);
+
+		// NOTE: If the points slid too far apart along the contact
+		// plane, the contact doesn't represent the same features
+		// anymore.
+		Vector3 tangential = diff - normal * separation;
+		if(v3_norm2(tangential) > linear_tolerance2)
+			return false;
+
+		points1[i] = point1;
+		points2[i] = point2;
+		separations[i] = separation;
+	}
+
+	for(i32 i = 0; i < pm->num_points; i += 1){
+		GJK_ManifoldPoint *point = &pm->points[i];
+		point->contact.point1 = points1[i];
+		point->contact.point2 = points2[i];
+		point->contact.separation = separations[i];
+		point->age += 1;
+	}
+	pm->normal = normal;
+	return true;
+}
+
+void gjk_persistent_manifold_merge(GJK_PersistentManifold *pm,
+		GJK_Manifold *manifold, const Transform &t1, const Transform &t2){
+	GJK_ManifoldPoint old_points[GJK_MAX_CONTACTS];
+	bool old_matched[GJK_MAX_CONTACTS] = {};
+	i32 num_old_points = pm->valid ? pm->num_points : 0;
+	for(i32 i = 0; i < num_old_points; i += 1)
+		old_points[i] = pm->points[i];
+
+	Transform inv1 = transform_inverse(t1);
+	Transform inv2 = transform_inverse(t2);
+	for(i32 i = 0; i < manifold->num_contacts; i += 1){
+		GJK_Contact *contact = &manifold->contacts[i];
+		GJK_ManifoldPoint *point = &pm->points[i];
+		point->contact = *contact;
+		point->local1 = transform_point(inv1, contact->point1);
+		point->local2 = transform_point(inv2, contact->point2);
+		point->normal_impulse = 0.0f;
+		point->tangent_impulse[0] = 0.0f;
+		point->tangent_impulse[1] = 0.0f;
+		point->age = 0;
+
+		i32 match = -1;
+		for(i32 j = 0; j < num_old_points; j += 1){
+			if(!old_matched[j] && old_points[j].contact.feature_id == contact->feature_id){
+				match = j;
+				break;
+			}
+		}
+
+		if(match == -1){
+			f32 best_dist2 = GJK_PERSISTENT_MATCH_DISTANCE
+				* GJK_PERSISTENT_MATCH_DISTANCE;
+			for(i32 j = 0; j < num_old_points; j += 1){
+				if(old_matched[j])
+					continue;
+				f32 dist2 = v3_norm2(old_points[j].local1 - point->local1);
+				if(dist2 <= best_dist2){
+					best_dist2 = dist2;
+					match = j;
+				}
+			}
+		}
+
+		if(match != -1){
+			old_matched[match] = true;
+			point->normal_impulse = old_points[match].normal_impulse;
+			point->tangent_impulse[0] = old_points[match].tangent_impulse[0];
+			point->tangent_impulse[1] = old_points[match].tangent_impulse[1];
+			point->age = old_points[match].age + 1;
+		}
+	}
+
+	pm->num_points = manifold->num_contacts;
+	pm->normal = manifold->normal;
+	pm->local_normal = v3_rotate(manifold->normal, inv1.rotation);
+	pm->relative = inv1 * t2;
+	pm->valid = manifold->num_contacts > 0;
+}
+
+static
+void gjk_persistent_manifold_rebuild(GJK_PersistentManifold *pm,
+		GJK_Polygon *p1, const Transform &t1,
+		GJK_Polygon *p2, const Transform &t2,
+		GJK_Result *result, f32 margin){
+	GJK_Manifold manifold;
+	if(gjk_manifold_build(p1, p2, result, margin, &manifold))
+		gjk_persistent_manifold_merge(pm, &manifold, t1, t2);
+	else
+		gjk_persistent_manifold_reset(pm);
+}
+
+bool gjk_persistent_manifold_collide(GJK_PersistentManifold *pm,
+		GJK_Polygon *p1, const Transform &t1,
+		GJK_Polygon *p2, const Transform &t2, f32 margin){
+	if(gjk_persistent_manifold_refresh(pm, t1, t2))
+		return false;
+
+	GJK_Result result = gjk(p1, p2);
+	gjk_persistent_manifold_rebuild(pm, p1, t1, p2, t2, &result, margin);
+	return true;
+}
+
+bool gjk_persistent_manifold_collide_with_result(GJK_PersistentManifold *pm,
+		GJK_Polygon *p1, const Transform &t1,
+		GJK_Polygon *p2, const Transform &t2,
+		GJK_Result *result, f32 margin){
+	if(gjk_persistent_manifold_refresh(pm, t1, t2))
+		return false;
+
+	gjk_persistent_manifold_rebuild(pm, p1, t1, p2, t2, result, margin);
+	return true;
+}
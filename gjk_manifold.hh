@@ -0,0 +1,110 @@
+#ifndef GJK_GJK_MANIFOLD_HH_
+#define GJK_GJK_MANIFOLD_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+
+// NOTE: Vertices of a polygon within this distance of its support
+// plane are considered to be part of the same face.
+#define GJK_MANIFOLD_FACE_TOLERANCE (1.0e-2f)
+#define GJK_MANIFOLD_MAX_FACE_POINTS 64
+#define GJK_MAX_CONTACTS 4
+
+// NOTE: `feature_id` identifies which features produced the contact.
+// The high 16 bits are the index of the reference face edge that was
+// clipped (0xFFFF if none) and the low 16 bits are the index of the
+// incident vertex (or edge start). Single point contacts (vertex or
+// crossing edges) use the vertex index on polygon1 in the high bits
+// and on polygon2 in the low bits instead. It's stable while the same
+// features are touching so contacts can be matched across frames.
+#define GJK_FEATURE_NONE 0xFFFF
+
+struct GJK_Contact{
+	Vector3 point1;
+	Vector3 point2;
+	f32 separation;
+	u32 feature_id;
+};
+
+// NOTE: `normal` always points from polygon1 to polygon2 and the
+// separation of each contact is measured along it (negative means
+// penetration).
+struct GJK_Manifold{
+	Vector3 normal;
+	i32 num_contacts;
+	GJK_Contact contacts[GJK_MAX_CONTACTS];
+};
+
+// NOTE: Builds the manifold from the result of `gjk`. The reference
+// face is the support face (in the direction of the closest points)
+// with the most vertices and the incident face is clipped against
+// its sides. Only points within `margin` of the reference face are
+// kept and the result is reduced to at most 4 contacts.
+//
+//	There is no EPA yet so overlapping results can't be used here and
+// this returns false. `gjk_manifold_build_with_normal` can be used if
+// the normal is known from somewhere else.
+bool gjk_manifold_build(GJK_Polygon *p1, GJK_Polygon *p2,
+		GJK_Result *result, f32 margin, GJK_Manifold *manifold);
+bool gjk_manifold_build_with_normal(GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 normal, f32 margin, GJK_Manifold *manifold);
+
+// ----------------------------------------------------------------
+// Persistent Manifolds
+// ----------------------------------------------------------------
+// NOTE: A persistent manifold keeps the contacts of a pair between
+// frames. Contact points are also stored in the local space of each
+// body so they can be moved along with the bodies and the solver
+// impulses are kept for warm starting.
+//
+//	If the relative transform of the bodies moved less than the
+// tolerances below since the manifold was built, the contacts are
+// only refreshed from the local points and the narrowphase is skipped.
+// New contacts are matched to old ones by feature id first and then by
+// distance (in the local space of polygon1).
+#define GJK_PERSISTENT_LINEAR_TOLERANCE (5.0e-3f)
+#define GJK_PERSISTENT_ANGULAR_TOLERANCE (1.0e-5f) // 1 - |dot(q0, q1)|
+#define GJK_PERSISTENT_MATCH_DISTANCE (2.0e-2f)
+
+struct GJK_ManifoldPoint{
+	GJK_Contact contact;
+	Vector3 local1;
+	Vector3 local2;
+	f32 normal_impulse;
+	f32 tangent_impulse[2];
+	u32 age;
+};
+
+struct GJK_PersistentManifold{
+	bool valid;
+	Transform relative;
+	Vector3 local_normal;
+	Vector3 normal;
+	i32 num_points;
+	GJK_ManifoldPoint points[GJK_MAX_CONTACTS];
+};
+
+// NOTE: `t1` and `t2` are the transforms that took each polygon to the
+// world space points used by the narrowphase.
+//
+//	`refresh` returns false if the manifold needs to be rebuilt, and
+// leaves it untouched then. `merge` replaces the contacts with the ones
+// from a new manifold, keeping the impulses of matching contacts.
+// `collide` does both, only running gjk when needed, and returns true if
+// it did. `collide_with_result` builds from a gjk result the caller
+// already has for `p1` and `p2` instead.
+void gjk_persistent_manifold_reset(GJK_PersistentManifold *pm);
+bool gjk_persistent_manifold_refresh(GJK_PersistentManifold *pm,
+		const Transform &t1, const Transform &t2);
+void gjk_persistent_manifold_merge(GJK_PersistentManifold *pm,
+		GJK_Manifold *manifold, const Transform &t1, const Transform &t2);
+bool gjk_persistent_manifold_collide(GJK_PersistentManifold *pm,
+		GJK_Polygon *p1, const Transform &t1,
+		GJK_Polygon *p2, const Transform &t2, f32 margin);
+bool gjk_persistent_manifold_collide_with_result(GJK_PersistentManifold *pm,
+		GJK_Polygon *p1, const Transform &t1,
+		GJK_Polygon *p2, const Transform &t2,
+		GJK_Result *result, f32 margin);
+
+#endif //GJK_GJK_MANIFOLD_HH_
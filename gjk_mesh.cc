@@ -0,0 +1,640 @@
+#include "gjk_mesh.hh"
+#include "thread.hh"
+
+// NOTE: Barycentric weights below this are considered zero when
+// finding which feature of a triangle the closest point is on.
+#define GJK_TRIANGLE_FEATURE_TOLERANCE (1.0e-3f)
+
+// NOTE: An edge is convex if the opposite vertex of the neighbouring
+// triangle is below the triangle plane by more than this (as the cosine
+// of the angle between the normal and the direction to that vertex).
+#define GJK_EDGE_CONVEX_TOLERANCE (1.0e-3f)
+
+static INLINE
+Vector3 gjk_triangle_normal(const Vector3 &a, const Vector3 &b, const Vector3 &c){
+	return v3_cross(b - a, c - a);
+}
+
+static
+bool gjk_edge_is_convex(const Vector3 &normal, const Vector3 &edge_start, const Vector3 &opposite){
+	Vector3 dir = opposite - edge_start;
+	if(v3_cmp_zero(dir) || v3_cmp_zero(normal))
+		return true;
+	return v3_dot(v3_normalize(normal), v3_normalize(dir)) < -GJK_EDGE_CONVEX_TOLERANCE;
+}
+
+static
+void gjk_triangle_barycentric(const Vector3 *tri, const Vector3 &p, f32 *weights){
+	// NOTE: From Real-Time Collision Detection (Christer Ericson).
+	Vector3 v0 = tri[1] - tri[0];
+	Vector3 v1 = tri[2] - tri[0];
+	Vector3 v2 = p - tri[0];
+	f32 d00 = v3_dot(v0, v0);
+	f32 d01 = v3_dot(v0, v1);
+	f32 d11 = v3_dot(v1, v1);
+	f32 d20 = v3_dot(v2, v0);
+	f32 d21 = v3_dot(v2, v1);
+	f32 denom = d00 * d11 - d01 * d01;
+	weights[1] = (d11 * d20 - d01 * d21) / denom;
+	weights[2] = (d00 * d21 - d01 * d20) / denom;
+	weights[0] = 1.0f - weights[1] - weights[2];
+}
+
+static
+bool gjk_triangle_query(Vector3 *tri, u8 flags, GJK_Polygon *p,
+		f32 margin, GJK_MeshResult *out){
+	Vector3 face_normal = gjk_triangle_normal(tri[0], tri[1], tri[2]);
+	if(v3_cmp_zero(face_normal))
+		return false;
+	face_normal = v3_normalize(face_normal);
+
+	GJK_Polygon triangle = make_gjk_polygon(tri, 3);
+	GJK_Result result = gjk(&triangle, p);
+	if(!result.overlap && result.distance > margin)
+		return false;
+
+	// NOTE: There is no penetration depth without EPA so overlapping
+	// results always get the face normal.
+	Vector3 normal = face_normal;
+	Vector3 delta = result.closest2 - result.closest1;
+	if(!result.overlap && !v3_cmp_zero(delta)){
+		normal = v3_normalize(delta);
+
+		f32 weights[3];
+		gjk_triangle_barycentric(tri, result.closest1, weights);
+		i32 zero_mask = 0;
+		i32 num_zero = 0;
+		for(i32 i = 0; i < 3; i += 1){
+			if(weights[i] < GJK_TRIANGLE_FEATURE_TOLERANCE){
+				zero_mask |= 1 << i;
+				num_zero += 1;
+			}
+		}
+
+		bool convex = true;
+		if(num_zero == 2){
+			i32 vertex = (zero_mask & 1) == 0 ? 0 : ((zero_mask & 2) == 0 ? 1 : 2);
+			convex = (flags & GJK_TRIANGLE_VERTEX_CONVEX(vertex)) != 0;
+		}else if(num_zero == 1){
+			// NOTE: Edge `e` goes from vertex `e` to `e + 1` so the
+			// vertex with zero weight is `e + 2`.
+			i32 zero = (zero_mask & 1) ? 0 : ((zero_mask & 2) ? 1 : 2);
+			i32 edge = (zero + 1) % 3;
+			convex = (flags & GJK_TRIANGLE_EDGE_CONVEX(edge)) != 0;
+		}
+
+		if(!convex)
+			normal = face_normal;
+	}
+
+	out->normal = normal;
+	out->result = result;
+	return true;
+}
+
+// ----------------------------------------------------------------
+// Mesh
+// ----------------------------------------------------------------
+struct GJK_MeshEdge{
+	u32 other;
+	i32 triangle;
+	i32 edge;
+};
+
+static
+void gjk_mesh_compute_flags(Vector3 *vertices, i32 num_vertices,
+		const u32 *indices, i32 num_triangles, u8 *flags){
+	// NOTE: Edges are bucketed by their smaller vertex with a counting
+	// sort and matched by the other vertex inside each bucket, which
+	// only holds a handful of edges in a regular mesh.
+	i32 num_edges = num_triangles * 3;
+	GJK_MeshEdge *edges = (GJK_MeshEdge*)malloc(sizeof(GJK_MeshEdge) * num_edges);
+	i32 *bucket_start = (i32*)calloc(num_vertices + 1, sizeof(i32));
+	u8 *vertex_convex = (u8*)calloc(num_vertices, 1);
+	ASSERT(edges != NULL && bucket_start != NULL && vertex_convex != NULL);
+	for(i32 i = 0; i < num_edges; i += 1){
+		u32 a = indices[i];
+		u32 b = indices[(i % 3) == 2 ? i - 2 : i + 1];
+		bucket_start[(a < b ? a : b) + 1] += 1;
+	}
+	for(i32 i = 0; i < num_vertices; i += 1)
+		bucket_start[i + 1] += bucket_start[i];
+	for(i32 i = 0; i < num_triangles; i += 1){
+		flags[i] = 0;
+		for(i32 e = 0; e < 3; e += 1){
+			u32 a = indices[i * 3 + e];
+			u32 b = indices[i * 3 + (e + 1) % 3];
+			// NOTE: This leaves `bucket_start` pointing to the end of
+			// each bucket which is shifted back below.
+			GJK_MeshEdge *edge = &edges[bucket_start[a < b ? a : b]++];
+			edge->other = a < b ? b : a;
+			edge->triangle = i;
+			edge->edge = e;
+		}
+	}
+	for(i32 i = num_vertices; i > 0; i -= 1)
+		bucket_start[i] = bucket_start[i - 1];
+	bucket_start[0] = 0;
+
+	for(i32 v = 0; v < num_vertices; v += 1)
+	for(i32 i = bucket_start[v]; i < bucket_start[v + 1]; i += 1){
+		i32 other = -1;
+		i32 num_shared = 0;
+		for(i32 j = bucket_start[v]; j < bucket_start[v + 1]; j += 1){
+			if(j != i && edges[j].other == edges[i].other){
+				other = j;
+				num_shared += 1;
+			}
+		}
+
+		// NOTE: Boundary and non manifold edges are always convex.
+		const u32 *tri = &indices[edges[i].triangle * 3];
+		i32 e = edges[i].edge;
+		bool convex = true;
+		if(num_shared == 1){
+			const u32 *other_tri = &indices[edges[other].triangle * 3];
+			Vector3 opposite = vertices[other_tri[(edges[other].edge + 2) % 3]];
+			Vector3 normal = gjk_triangle_normal(
+				vertices[tri[0]], vertices[tri[1]], vertices[tri[2]]);
+			convex = gjk_edge_is_convex(normal, vertices[tri[e]], opposite);
+		}
+
+		if(convex){
+			flags[edges[i].triangle] |= GJK_TRIANGLE_EDGE_CONVEX(e);
+			vertex_convex[tri[e]] = 1;
+			vertex_convex[tri[(e + 1) % 3]] = 1;
+		}
+	}
+
+	// NOTE: A vertex is convex if any edge touching it is.
+	for(i32 i = 0; i < num_triangles; i += 1){
+		for(i32 v = 0; v < 3; v += 1){
+			if(vertex_convex[indices[i * 3 + v]])
+				flags[i] |= GJK_TRIANGLE_VERTEX_CONVEX(v);
+		}
+	}
+
+	free(edges);
+	free(bucket_start);
+	free(vertex_convex);
+}
+
+// NOTE: Binned SAH builder. Every split evaluates GJK_MESH_SAH_BINS
+// bins along each axis and leaves always have a single triangle, so
+// the subtree over `count` triangles has exactly `2 * count - 1` nodes.
+// That means the position of each child in the depth first array is
+// known before its sibling is built (left at `node + 1` and right at
+// `node + 2 * left_count`) and subtrees can be built in parallel
+// without any synchronization. The right subtree is handed to a new
+// thread on the first few levels.
+#define GJK_MESH_SAH_BINS 16
+#define GJK_MESH_PARALLEL_MIN_TRIANGLES 4096
+
+struct GJK_MeshBuilder{
+	GJK_Mesh *mesh;
+	const AABB *bounds;
+	const Vector3 *centroids;
+	const u32 *indices;
+	const u8 *flags;
+	i32 *order;
+	i32 spawn_depth;
+};
+
+struct GJK_MeshBuildTask{
+	GJK_MeshBuilder *builder;
+	i32 first;
+	i32 count;
+	i32 node_index;
+	i32 depth;
+};
+
+struct GJK_MeshBin{
+	AABB bounds;
+	i32 count;
+};
+
+static INLINE
+f32 gjk_aabb_half_area(const AABB &box){
+	Vector3 extent = box.max - box.min;
+	return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+// NOTE: Partitions `order[first .. first + count)` and returns the
+// number of triangles on the left side, which is never 0 or `count`.
+static
+i32 gjk_mesh_sah_split(GJK_MeshBuilder *builder, i32 first, i32 count,
+		const AABB &centroid_bounds){
+	const i32 num_bins = GJK_MESH_SAH_BINS;
+	GJK_MeshBin bins[3][GJK_MESH_SAH_BINS];
+	f32 bin_scale[3];
+	Vector3 extent = centroid_bounds.max - centroid_bounds.min;
+	for(i32 axis = 0; axis < 3; axis += 1){
+		f32 axis_extent = v3_axis(extent, axis);
+		bin_scale[axis] = axis_extent > 0.0f
+			? ((f32)num_bins * 0.9999f) / axis_extent : 0.0f;
+		for(i32 i = 0; i < num_bins; i += 1)
+			bins[axis][i].count = 0;
+	}
+
+	i32 *order = builder->order;
+	for(i32 i = first; i < (first + count); i += 1){
+		i32 triangle = order[i];
+		Vector3 centroid = builder->centroids[triangle];
+		for(i32 axis = 0; axis < 3; axis += 1){
+			i32 bin = (i32)((v3_axis(centroid, axis)
+				- v3_axis(centroid_bounds.min, axis)) * bin_scale[axis]);
+			if(bin > (num_bins - 1)) bin = num_bins - 1;
+			GJK_MeshBin *b = &bins[axis][bin];
+			b->bounds = (b->count == 0) ? builder->bounds[triangle]
+				: aabb_union(b->bounds, builder->bounds[triangle]);
+			b->count += 1;
+		}
+	}
+
+	i32 best_axis = -1;
+	i32 best_bin = -1;
+	f32 best_cost = FLT_MAX;
+	for(i32 axis = 0; axis < 3; axis += 1){
+		if(bin_scale[axis] == 0.0f)
+			continue;
+
+		// NOTE: Sweep from the right to get the cost of the right side
+		// of each split, then from the left to finish it.
+		f32 right_cost[GJK_MESH_SAH_BINS];
+		AABB right_bounds = {};
+		i32 right_count = 0;
+		for(i32 i = num_bins - 1; i > 0; i -= 1){
+			GJK_MeshBin *b = &bins[axis][i];
+			if(b->count > 0){
+				right_bounds = (right_count == 0) ? b->bounds
+					: aabb_union(right_bounds, b->bounds);
+				right_count += b->count;
+			}
+			right_cost[i - 1] = (right_count > 0)
+				? gjk_aabb_half_area(right_bounds) * (f32)right_count : 0.0f;
+		}
+
+		AABB left_bounds = {};
+		i32 left_count = 0;
+		for(i32 i = 0; i < (num_bins - 1); i += 1){
+			GJK_MeshBin *b = &bins[axis][i];
+			if(b->count > 0){
+				left_bounds = (left_count == 0) ? b->bounds
+					: aabb_union(left_bounds, b->bounds);
+				left_count += b->count;
+			}
+			if(left_count == 0 || left_count == count)
+				continue;
+			f32 cost = gjk_aabb_half_area(left_bounds) * (f32)left_count + right_cost[i];
+			if(cost < best_cost){
+				best_cost = cost;
+				best_axis = axis;
+				best_bin = i;
+			}
+		}
+	}
+
+	// NOTE: All centroids are at the same point. Any split is as good
+	// as any other.
+	if(best_axis == -1)
+		return count / 2;
+
+	i32 i = first;
+	i32 j = first + count - 1;
+	f32 min = v3_axis(centroid_bounds.min, best_axis);
+	f32 scale = bin_scale[best_axis];
+	while(i <= j){
+		Vector3 centroid = builder->centroids[order[i]];
+		i32 bin = (i32)((v3_axis(centroid, best_axis) - min) * scale);
+		if(bin <= best_bin){
+			i += 1;
+		}else{
+			i32 tmp = order[i];
+			order[i] = order[j];
+			order[j] = tmp;
+			j -= 1;
+		}
+	}
+
+	i32 left_count = i - first;
+	ASSERT(left_count > 0 && left_count < count);
+	return left_count;
+}
+
+static
+void gjk_mesh_quantize(GJK_Mesh *mesh, const AABB &box, u16 *qmin, u16 *qmax){
+	for(i32 axis = 0; axis < 3; axis += 1){
+		f32 origin = v3_axis(mesh->bounds.min, axis);
+		f32 scale = v3_axis(mesh->quantize_scale, axis);
+		f32 lo = floorf((v3_axis(box.min, axis) - origin) * scale);
+		f32 hi = ceilf((v3_axis(box.max, axis) - origin) * scale);
+		qmin[axis] = (u16)(lo < 0.0f ? 0.0f : (lo > 65535.0f ? 65535.0f : lo));
+		qmax[axis] = (u16)(hi < 0.0f ? 0.0f : (hi > 65535.0f ? 65535.0f : hi));
+	}
+}
+
+static void gjk_mesh_build_task(void *arg);
+
+static
+void gjk_mesh_build_node(GJK_MeshBuilder *builder,
+		i32 first, i32 count, i32 node_index, i32 depth){
+	GJK_Mesh *mesh = builder->mesh;
+	GJK_MeshNode *node = &mesh->nodes[node_index];
+	if(count == 1){
+		// NOTE: Leaves are in the same order as `order` so the slot of
+		// the triangle is its position there.
+		i32 slot = first;
+		i32 triangle = builder->order[first];
+		mesh->triangles[slot * 3 + 0] = builder->indices[triangle * 3 + 0];
+		mesh->triangles[slot * 3 + 1] = builder->indices[triangle * 3 + 1];
+		mesh->triangles[slot * 3 + 2] = builder->indices[triangle * 3 + 2];
+		mesh->triangle_ids[slot] = (u32)triangle;
+		mesh->triangle_flags[slot] = builder->flags[triangle];
+		gjk_mesh_quantize(mesh, builder->bounds[triangle], node->qmin, node->qmax);
+		node->data = slot;
+		return;
+	}
+
+	i32 *order = builder->order;
+	AABB node_bounds = builder->bounds[order[first]];
+	Vector3 centroid = builder->centroids[order[first]];
+	AABB centroid_bounds = make_aabb(centroid, centroid);
+	for(i32 i = first + 1; i < (first + count); i += 1){
+		node_bounds = aabb_union(node_bounds, builder->bounds[order[i]]);
+		centroid = builder->centroids[order[i]];
+		centroid_bounds = aabb_union(centroid_bounds, make_aabb(centroid, centroid));
+	}
+	gjk_mesh_quantize(mesh, node_bounds, node->qmin, node->qmax);
+	node->data = -(2 * count - 1);
+
+	i32 left_count = gjk_mesh_sah_split(builder, first, count, centroid_bounds);
+	i32 left_index = node_index + 1;
+	i32 right_index = node_index + 2 * left_count;
+	if(depth < builder->spawn_depth && count >= GJK_MESH_PARALLEL_MIN_TRIANGLES){
+		GJK_MeshBuildTask task;
+		task.builder = builder;
+		task.first = first + left_count;
+		task.count = count - left_count;
+		task.node_index = right_index;
+		task.depth = depth + 1;
+		Thread *thread = thread_create(gjk_mesh_build_task, &task);
+		gjk_mesh_build_node(builder, first, left_count, left_index, depth + 1);
+		thread_join(thread);
+	}else{
+		gjk_mesh_build_node(builder, first, left_count, left_index, depth + 1);
+		gjk_mesh_build_node(builder, first + left_count,
+			count - left_count, right_index, depth + 1);
+	}
+}
+
+static
+void gjk_mesh_build_task(void *arg){
+	GJK_MeshBuildTask *task = (GJK_MeshBuildTask*)arg;
+	gjk_mesh_build_node(task->builder, task->first,
+		task->count, task->node_index, task->depth);
+}
+
+GJK_Mesh gjk_mesh_create(Vector3 *vertices, i32 num_vertices,
+		const u32 *indices, i32 num_triangles, i32 num_threads){
+	ASSERT(num_triangles > 0);
+	GJK_Mesh result;
+	result.num_vertices = num_vertices;
+	result.vertices = vertices;
+	result.num_triangles = num_triangles;
+	result.triangles = (u32*)malloc(sizeof(u32) * 3 * num_triangles);
+	result.triangle_ids = (u32*)malloc(sizeof(u32) * num_triangles);
+	result.triangle_flags = (u8*)malloc(num_triangles);
+	result.num_nodes = 2 * num_triangles - 1;
+	result.nodes = (GJK_MeshNode*)malloc(sizeof(GJK_MeshNode) * result.num_nodes);
+	ASSERT(result.triangles != NULL && result.triangle_ids != NULL
+		&& result.triangle_flags != NULL && result.nodes != NULL);
+
+	AABB *bounds = (AABB*)malloc(sizeof(AABB) * num_triangles);
+	Vector3 *centroids = (Vector3*)malloc(sizeof(Vector3) * num_triangles);
+	i32 *order = (i32*)malloc(sizeof(i32) * num_triangles);
+	u8 *flags = (u8*)malloc(num_triangles);
+	ASSERT(bounds != NULL && centroids != NULL && order != NULL && flags != NULL);
+	for(i32 i = 0; i < num_triangles; i += 1){
+		Vector3 a = vertices[indices[i * 3 + 0]];
+		Vector3 b = vertices[indices[i * 3 + 1]];
+		Vector3 c = vertices[indices[i * 3 + 2]];
+		bounds[i] = aabb_union(make_aabb(a, a), aabb_union(make_aabb(b, b), make_aabb(c, c)));
+		centroids[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+		order[i] = i;
+		result.bounds = (i == 0) ? bounds[i] : aabb_union(result.bounds, bounds[i]);
+	}
+	gjk_mesh_compute_flags(vertices, num_vertices, indices, num_triangles, flags);
+
+	// NOTE: Flat meshes have a zero extent along some axis.
+	Vector3 extent = result.bounds.max - result.bounds.min;
+	result.quantize_scale = make_v3(
+		extent.x > F32_EPSILON ? 65535.0f / extent.x : 0.0f,
+		extent.y > F32_EPSILON ? 65535.0f / extent.y : 0.0f,
+		extent.z > F32_EPSILON ? 65535.0f / extent.z : 0.0f);
+
+	// NOTE: Spawning on the first N levels gives up to 2^N threads.
+	i32 spawn_depth = 0;
+	while((1 << spawn_depth) < num_threads)
+		spawn_depth += 1;
+
+	GJK_MeshBuilder builder;
+	builder.mesh = &result;
+	builder.bounds = bounds;
+	builder.centroids = centroids;
+	builder.indices = indices;
+	builder.flags = flags;
+	builder.order = order;
+	builder.spawn_depth = spawn_depth;
+	gjk_mesh_build_node(&builder, 0, num_triangles, 0, 0);
+
+	free(bounds);
+	free(centroids);
+	free(order);
+	free(flags);
+	return result;
+}
+
+void gjk_mesh_free(GJK_Mesh *mesh){
+	free(mesh->triangles);
+	free(mesh->triangle_ids);
+	free(mesh->triangle_flags);
+	free(mesh->nodes);
+	mesh->triangles = NULL;
+	mesh->triangle_ids = NULL;
+	mesh->triangle_flags = NULL;
+	mesh->nodes = NULL;
+	mesh->num_triangles = 0;
+	mesh->num_nodes = 0;
+}
+
+static
+AABB gjk_polygon_bounds(GJK_Polygon *p, f32 margin){
+	ASSERT(p->num_points > 0);
+	Vector3 point = gjk_polygon_point(p, 0);
+	AABB result = make_aabb(point, point);
+	for(i32 i = 1; i < p->num_points; i += 1){
+		point = gjk_polygon_point(p, i);
+		result = aabb_union(result, make_aabb(point, point));
+	}
+	Vector3 m = make_v3(margin, margin, margin) + gjk_polygon_error(p);
+	result.min -= m;
+	result.max += m;
+	return result;
+}
+
+i32 gjk_mesh_query(GJK_Mesh *mesh, GJK_Polygon *p, f32 margin,
+		GJK_MeshResult *results, i32 max_results){
+	AABB query = gjk_polygon_bounds(p, margin);
+	if(!aabb_overlap(query, mesh->bounds))
+		return 0;
+
+	u16 qmin[3], qmax[3];
+	gjk_mesh_quantize(mesh, query, qmin, qmax);
+
+	i32 num_results = 0;
+	i32 index = 0;
+	while(index < mesh->num_nodes && num_results < max_results){
+		GJK_MeshNode *node = &mesh->nodes[index];
+		bool overlap = qmin[0] <= node->qmax[0] && qmax[0] >= node->qmin[0]
+			&& qmin[1] <= node->qmax[1] && qmax[1] >= node->qmin[1]
+			&& qmin[2] <= node->qmax[2] && qmax[2] >= node->qmin[2];
+
+		if(node->data >= 0){
+			if(overlap){
+				u32 *tri = &mesh->triangles[node->data * 3];
+				Vector3 points[3];
+				points[0] = mesh->vertices[tri[0]];
+				points[1] = mesh->vertices[tri[1]];
+				points[2] = mesh->vertices[tri[2]];
+				GJK_MeshResult *out = &results[num_results];
+				if(gjk_triangle_query(points, mesh->triangle_flags[node->data], p, margin, out)){
+					out->triangle = (i32)mesh->triangle_ids[node->data];
+					num_results += 1;
+				}
+			}
+			index += 1;
+		}else{
+			index += overlap ? 1 : -node->data;
+		}
+	}
+	return num_results;
+}
+
+// ----------------------------------------------------------------
+// Heightfield
+// ----------------------------------------------------------------
+GJK_Heightfield make_gjk_heightfield(f32 *heights, i32 num_rows, i32 num_cols,
+		Vector3 origin, f32 cell_size){
+	ASSERT(num_rows >= 2 && num_cols >= 2);
+	GJK_Heightfield result;
+	result.num_rows = num_rows;
+	result.num_cols = num_cols;
+	result.heights = heights;
+	result.origin = origin;
+	result.cell_size = cell_size;
+	result.min_height = heights[0];
+	result.max_height = heights[0];
+	for(i32 i = 1; i < num_rows * num_cols; i += 1){
+		if(heights[i] < result.min_height) result.min_height = heights[i];
+		if(heights[i] > result.max_height) result.max_height = heights[i];
+	}
+	return result;
+}
+
+static INLINE
+Vector3 gjk_heightfield_point(GJK_Heightfield *hf, i32 row, i32 col){
+	return hf->origin + make_v3(
+		(f32)col * hf->cell_size,
+		hf->heights[row * hf->num_cols + col],
+		(f32)row * hf->cell_size);
+}
+
+// NOTE: Offsets (row, col) from the cell to the vertices of both
+// triangles (wound so that the normal points up) and to the opposite
+// vertex of the triangle sharing each edge.
+static const i32 gjk_heightfield_vertex[2][3][2] = {
+	{ {0, 0}, {1, 1}, {0, 1} },
+	{ {0, 0}, {1, 0}, {1, 1} },
+};
+static const i32 gjk_heightfield_opposite[2][3][2] = {
+	{ {1, 0}, {1, 2}, {-1, 0} },
+	{ {0, -1}, {2, 1}, {0, 1} },
+};
+
+static
+i32 gjk_heightfield_cell_range(f32 min, f32 max, f32 origin, f32 cell_size,
+		i32 num_cells, i32 *first, i32 *last){
+	*first = (i32)floorf((min - origin) / cell_size);
+	*last = (i32)floorf((max - origin) / cell_size);
+	if(*first < 0) *first = 0;
+	if(*last > num_cells - 1) *last = num_cells - 1;
+	return *last - *first + 1;
+}
+
+i32 gjk_heightfield_query(GJK_Heightfield *hf, GJK_Polygon *p, f32 margin,
+		GJK_MeshResult *results, i32 max_results){
+	AABB query = gjk_polygon_bounds(p, margin);
+	if(query.max.y < (hf->origin.y + hf->min_height)
+	|| query.min.y > (hf->origin.y + hf->max_height))
+		return 0;
+
+	i32 row0, row1, col0, col1;
+	if(gjk_heightfield_cell_range(query.min.z, query.max.z, hf->origin.z,
+			hf->cell_size, hf->num_rows - 1, &row0, &row1) <= 0
+	|| gjk_heightfield_cell_range(query.min.x, query.max.x, hf->origin.x,
+			hf->cell_size, hf->num_cols - 1, &col0, &col1) <= 0)
+		return 0;
+
+	i32 num_results = 0;
+	for(i32 row = row0; row <= row1; row += 1)
+	for(i32 col = col0; col <= col1; col += 1){
+		// NOTE: Skip the cell if its height range is outside the query.
+		f32 *h = &hf->heights[row * hf->num_cols + col];
+		f32 cell_min = h[0], cell_max = h[0];
+		f32 corners[3] = { h[1], h[hf->num_cols], h[hf->num_cols + 1] };
+		for(i32 i = 0; i < 3; i += 1){
+			if(corners[i] < cell_min) cell_min = corners[i];
+			if(corners[i] > cell_max) cell_max = corners[i];
+		}
+		if(query.max.y < (hf->origin.y + cell_min)
+		|| query.min.y > (hf->origin.y + cell_max))
+			continue;
+
+		for(i32 k = 0; k < 2; k += 1){
+			if(num_results >= max_results)
+				return num_results;
+
+			Vector3 tri[3];
+			for(i32 v = 0; v < 3; v += 1){
+				tri[v] = gjk_heightfield_point(hf,
+					row + gjk_heightfield_vertex[k][v][0],
+					col + gjk_heightfield_vertex[k][v][1]);
+			}
+
+			u8 flags = 0;
+			Vector3 normal = gjk_triangle_normal(tri[0], tri[1], tri[2]);
+			for(i32 e = 0; e < 3; e += 1){
+				i32 opp_row = row + gjk_heightfield_opposite[k][e][0];
+				i32 opp_col = col + gjk_heightfield_opposite[k][e][1];
+				bool convex = true;
+				if(opp_row >= 0 && opp_row < hf->num_rows
+				&& opp_col >= 0 && opp_col < hf->num_cols){
+					Vector3 opposite = gjk_heightfield_point(hf, opp_row, opp_col);
+					convex = gjk_edge_is_convex(normal, tri[e], opposite);
+				}
+				if(convex){
+					flags |= GJK_TRIANGLE_EDGE_CONVEX(e);
+					flags |= GJK_TRIANGLE_VERTEX_CONVEX(e);
+					flags |= GJK_TRIANGLE_VERTEX_CONVEX((e + 1) % 3);
+				}
+			}
+
+			GJK_MeshResult *out = &results[num_results];
+			if(gjk_triangle_query(tri, flags, p, margin, out)){
+				out->triangle = ((row * (hf->num_cols - 1)) + col) * 2 + k;
+				num_results += 1;
+			}
+		}
+	}
+	return num_results;
+}
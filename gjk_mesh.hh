@@ -0,0 +1,101 @@
+#ifndef GJK_GJK_MESH_HH_
+#define GJK_GJK_MESH_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+
+// NOTE: Static triangle meshes and heightfields, in world space. Each
+// candidate triangle is tested with `gjk` as a three point polygon.
+//
+//	Internal edge filtering: a convex sliding over a flat (or concave)
+// edge between two triangles would get a normal from the edge instead
+// of the faces and catch on it. Edges (and vertices) are flagged as
+// convex when they can produce a normal other than the face normal and
+// contacts on non convex features get the face normal instead.
+#define GJK_TRIANGLE_EDGE_CONVEX(e) (1 << (e))
+#define GJK_TRIANGLE_VERTEX_CONVEX(v) (1 << (3 + (v)))
+#define GJK_TRIANGLE_ALL_CONVEX 0x3F
+
+// NOTE: `normal` points from the triangle to the convex.
+struct GJK_MeshResult{
+	i32 triangle;
+	Vector3 normal;
+	GJK_Result result;
+};
+
+// ----------------------------------------------------------------
+// Mesh
+// ----------------------------------------------------------------
+// NOTE: The BVH is stored in depth first order with one triangle per
+// leaf so it can be traversed without a stack. Inner nodes store how
+// many nodes to skip if their bounds are missed. Bounds are quantized
+// to 16 bits relative to the mesh bounds, rounded outwards, which
+// makes each node 16 bytes.
+//
+//	Triangles are reordered to follow the leaves. `triangle_ids` maps
+// them back to the index given by the user which is what's reported
+// in `GJK_MeshResult`. Edge adjacency is found by vertex index so
+// vertices must be welded for internal edge filtering to work.
+struct GJK_MeshNode{
+	u16 qmin[3];
+	u16 qmax[3];
+	// NOTE: >= 0 is the triangle of a leaf and < 0 is minus the
+	// size of the subtree of an inner node.
+	i32 data;
+};
+
+struct GJK_Mesh{
+	i32 num_vertices;
+	Vector3 *vertices;
+
+	i32 num_triangles;
+	u32 *triangles;
+	u32 *triangle_ids;
+	u8 *triangle_flags;
+
+	AABB bounds;
+	Vector3 quantize_scale;
+	i32 num_nodes;
+	GJK_MeshNode *nodes;
+};
+
+// NOTE: `vertices` are referenced, `indices` (3 per triangle) are
+// copied. The BVH is built with a binned SAH on up to `num_threads`
+// threads.
+GJK_Mesh gjk_mesh_create(Vector3 *vertices, i32 num_vertices,
+		const u32 *indices, i32 num_triangles, i32 num_threads);
+void gjk_mesh_free(GJK_Mesh *mesh);
+
+// NOTE: Writes the triangles that overlap or are within `margin` of `p`
+// into `results` and returns how many were written (at most
+// `max_results`).
+i32 gjk_mesh_query(GJK_Mesh *mesh, GJK_Polygon *p, f32 margin,
+		GJK_MeshResult *results, i32 max_results);
+
+// ----------------------------------------------------------------
+// Heightfield
+// ----------------------------------------------------------------
+// NOTE: A regular grid of heights along the Y axis. Sample (row, col)
+// is at origin + (col * cell_size, heights[row * num_cols + col],
+// row * cell_size). Each cell is split into two triangles along the
+// diagonal from (row, col) to (row + 1, col + 1) and triangle ids are
+// (row * (num_cols - 1) + col) * 2 + k. The grid is indexed directly
+// so there is no tree to build.
+struct GJK_Heightfield{
+	i32 num_rows;
+	i32 num_cols;
+	f32 *heights;
+	Vector3 origin;
+	f32 cell_size;
+	f32 min_height;
+	f32 max_height;
+};
+
+// NOTE: `heights` are referenced.
+GJK_Heightfield make_gjk_heightfield(f32 *heights, i32 num_rows, i32 num_cols,
+		Vector3 origin, f32 cell_size);
+i32 gjk_heightfield_query(GJK_Heightfield *hf, GJK_Polygon *p, f32 margin,
+		GJK_MeshResult *results, i32 max_results);
+
+#endif //GJK_GJK_MESH_HH_
@@ -0,0 +1,194 @@
+#include "gjk_pair_cache.hh"
+
+static INLINE
+u32 gjk_pair_hash(u64 key){
+	// NOTE: This is the 64-bit finalizer from MurmurHash3.
+	key ^= key >> 33;
+	key *= 0xFF51AFD7ED558CCDULL;
+	key ^= key >> 33;
+	key *= 0xC4CEB9FE1A85EC53ULL;
+	key ^= key >> 33;
+	return (u32)key;
+}
+
+static
+GJK_PairEntry *gjk_pair_cache_alloc_entries(u32 capacity){
+	GJK_PairEntry *entries = (GJK_PairEntry*)malloc(sizeof(GJK_PairEntry) * capacity);
+	ASSERT(entries != NULL);
+	for(u32 i = 0; i < capacity; i += 1)
+		entries[i].key = GJK_PAIR_EMPTY_KEY;
+	return entries;
+}
+
+GJK_PairCache gjk_pair_cache_init(u32 capacity, bool fixed_capacity, u32 max_age){
+	ASSERT(IS_POWER_OF_TWO(capacity));
+	GJK_PairCache result;
+	result.entries = gjk_pair_cache_alloc_entries(capacity);
+	result.capacity = capacity;
+	// NOTE: Linear probing degrades quickly with high load factors.
+	// In fixed capacity mode we let it go up to 7/8 since the other
+	// option is to fail the insert. Otherwise we grow at 1/2.
+	result.max_count = fixed_capacity
+		? (capacity - (capacity / 8))
+		: (capacity / 2);
+	result.count = 0;
+	result.num_failed_inserts = 0;
+	result.fixed_capacity = fixed_capacity;
+	result.frame = 0;
+	result.max_age = max_age;
+	return result;
+}
+
+void gjk_pair_cache_free(GJK_PairCache *cache){
+	free(cache->entries);
+	cache->entries = NULL;
+	cache->capacity = 0;
+	cache->count = 0;
+}
+
+static
+void gjk_pair_cache_evict(GJK_PairCache *cache){
+	// NOTE: Backward shift deletion. After removing an entry, we move
+	// back any entry further along the probe sequence that would be
+	// unreachable otherwise. This way we don't need tombstones which
+	// would make parallel inserts more complicated.
+	u32 mask = cache->capacity - 1;
+	GJK_PairEntry *entries = cache->entries;
+	u32 i = 0;
+	while(i < cache->capacity){
+		GJK_PairEntry *entry = &entries[i];
+		if(entry->key == GJK_PAIR_EMPTY_KEY
+				|| (cache->frame - entry->last_frame) <= cache->max_age){
+			i += 1;
+			continue;
+		}
+
+		u32 hole = i;
+		u32 j = i;
+		while(1){
+			j = (j + 1) & mask;
+			if(entries[j].key == GJK_PAIR_EMPTY_KEY)
+				break;
+
+			// NOTE: Entry `j` can fill the hole if its home slot is
+			// not cyclically in (hole, j].
+			u32 home = gjk_pair_hash(entries[j].key) & mask;
+			if(((j - home) & mask) >= ((j - hole) & mask)){
+				entries[hole] = entries[j];
+				hole = j;
+			}
+		}
+		entries[hole].key = GJK_PAIR_EMPTY_KEY;
+		cache->count -= 1;
+
+		// NOTE: Don't advance `i` because some other entry may have
+		// been moved into it. If the probe sequence wrapped around
+		// and moved an entry behind `i` we'll miss it this frame but
+		// it will be evicted on the next one.
+	}
+}
+
+static
+void gjk_pair_cache_grow(GJK_PairCache *cache){
+	u32 old_capacity = cache->capacity;
+	GJK_PairEntry *old_entries = cache->entries;
+
+	u32 capacity = 2 * old_capacity;
+	u32 mask = capacity - 1;
+	GJK_PairEntry *entries = gjk_pair_cache_alloc_entries(capacity);
+	for(u32 i = 0; i < old_capacity; i += 1){
+		if(old_entries[i].key == GJK_PAIR_EMPTY_KEY)
+			continue;
+		u32 j = gjk_pair_hash(old_entries[i].key) & mask;
+		while(entries[j].key != GJK_PAIR_EMPTY_KEY)
+			j = (j + 1) & mask;
+		entries[j] = old_entries[i];
+	}
+	free(old_entries);
+
+	cache->entries = entries;
+	cache->capacity = capacity;
+	cache->max_count = capacity / 2;
+}
+
+void gjk_pair_cache_begin_frame(GJK_PairCache *cache){
+	cache->frame += 1;
+	gjk_pair_cache_evict(cache);
+	if(!cache->fixed_capacity){
+		while((cache->count + cache->num_failed_inserts) >= cache->max_count)
+			gjk_pair_cache_grow(cache);
+	}
+	cache->num_failed_inserts = 0;
+}
+
+void gjk_pair_cache_reserve(GJK_PairCache *cache, u32 num_inserts){
+	if(cache->fixed_capacity)
+		return;
+	while((cache->count + num_inserts) >= cache->max_count)
+		gjk_pair_cache_grow(cache);
+}
+
+GJK_PairState *gjk_pair_cache_find(GJK_PairCache *cache, u32 id1, u32 id2){
+	u64 key = gjk_pair_key(id1, id2);
+	ASSERT(key != GJK_PAIR_EMPTY_KEY);
+	u32 mask = cache->capacity - 1;
+	u32 i = gjk_pair_hash(key) & mask;
+	for(u32 num_probes = 0; num_probes < cache->capacity; num_probes += 1){
+		GJK_PairEntry *entry = &cache->entries[i];
+		u64 entry_key = atomic_load_u64(&entry->key);
+		if(entry_key == key){
+			entry->last_frame = cache->frame;
+			return &entry->state;
+		}
+		if(entry_key == GJK_PAIR_EMPTY_KEY)
+			break;
+		i = (i + 1) & mask;
+	}
+	return NULL;
+}
+
+GJK_PairState *gjk_pair_cache_find_or_insert(GJK_PairCache *cache,
+		u32 id1, u32 id2, bool *inserted){
+	u64 key = gjk_pair_key(id1, id2);
+	ASSERT(key != GJK_PAIR_EMPTY_KEY);
+	u32 mask = cache->capacity - 1;
+	u32 i = gjk_pair_hash(key) & mask;
+	for(u32 num_probes = 0; num_probes < cache->capacity; num_probes += 1){
+		GJK_PairEntry *entry = &cache->entries[i];
+		u64 entry_key = atomic_load_u64(&entry->key);
+		if(entry_key == GJK_PAIR_EMPTY_KEY){
+			// NOTE: Reserve the count first so we never go over
+			// `max_count` even with parallel inserts.
+			if(atomic_add_u32(&cache->count, 1) >= cache->max_count){
+				atomic_add_u32(&cache->count, (u32)-1);
+				break;
+			}
+
+			entry_key = atomic_cas_u64(&entry->key, GJK_PAIR_EMPTY_KEY, key);
+			if(entry_key == GJK_PAIR_EMPTY_KEY){
+				GJK_PairState zero_state = {};
+				entry->last_frame = cache->frame;
+				entry->state = zero_state;
+				if(inserted)
+					*inserted = true;
+				return &entry->state;
+			}
+
+			// NOTE: Some other thread took this slot first.
+			atomic_add_u32(&cache->count, (u32)-1);
+		}
+
+		if(entry_key == key){
+			entry->last_frame = cache->frame;
+			if(inserted)
+				*inserted = false;
+			return &entry->state;
+		}
+		i = (i + 1) & mask;
+	}
+
+	atomic_add_u32(&cache->num_failed_inserts, 1);
+	if(inserted)
+		*inserted = false;
+	return NULL;
+}
@@ -0,0 +1,81 @@
+#ifndef GJK_GJK_PAIR_CACHE_HH_
+#define GJK_GJK_PAIR_CACHE_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+#include "gjk_manifold.hh"
+
+// NOTE: Per pair state that is carried from one frame to the next.
+struct GJK_PairState{
+	bool overlap;
+	f32 distance;
+	Vector3 separating_axis;
+	GJK_PersistentManifold manifold;
+
+	// NOTE: Versions of the shapes when `result` was computed, so callers
+	// that track motion can skip pairs that didn't move (see gjk_world.hh).
+	// They start at zero which should never be a valid version.
+	u32 version1;
+	u32 version2;
+	GJK_Result result;
+};
+
+// NOTE: This is an open addressing hash map (linear probing) keyed by
+// the ordered pair of shape ids. (a, b) and (b, a) are different pairs
+// because the state depends on the order of the polygons.
+//
+//	Lookups and inserts may be done in parallel as long as each pair is
+// only accessed by one thread per frame. Eviction and growth happen in
+// `gjk_pair_cache_begin_frame` which must be called when no other
+// thread is using the cache. Entries not used for more than `max_age`
+// frames are evicted there.
+//
+//	With `fixed_capacity`, the cache never allocates after it's created
+// and inserts fail (return NULL) when it's full. Otherwise it grows in
+// `gjk_pair_cache_begin_frame`, if inserts failed on the previous frame,
+// so it still won't allocate mid frame.
+#define GJK_PAIR_EMPTY_KEY 0xFFFFFFFFFFFFFFFFULL
+
+struct GJK_PairEntry{
+	volatile u64 key;
+	u32 last_frame;
+	GJK_PairState state;
+};
+
+struct GJK_PairCache{
+	GJK_PairEntry *entries;
+	u32 capacity;
+	u32 max_count;
+	volatile u32 count;
+	volatile u32 num_failed_inserts;
+
+	bool fixed_capacity;
+	u32 frame;
+	u32 max_age;
+};
+
+static INLINE
+u64 gjk_pair_key(u32 id1, u32 id2){
+	return ((u64)id1 << 32) | (u64)id2;
+}
+
+GJK_PairCache gjk_pair_cache_init(u32 capacity, bool fixed_capacity, u32 max_age);
+void gjk_pair_cache_free(GJK_PairCache *cache);
+void gjk_pair_cache_begin_frame(GJK_PairCache *cache);
+
+// NOTE: Grows the cache so that `num_inserts` more inserts can't fail.
+// Which inserts fail depends on thread timing so callers that need the
+// same state on every run reserve room before going parallel. It has the
+// same restrictions as `gjk_pair_cache_begin_frame` and does nothing with
+// `fixed_capacity`.
+void gjk_pair_cache_reserve(GJK_PairCache *cache, u32 num_inserts);
+
+// NOTE: Both return NULL if the pair is not in the cache. The insert
+// version will add it, with its state zeroed, unless the cache is full
+// in which case the caller should proceed without cached state.
+GJK_PairState *gjk_pair_cache_find(GJK_PairCache *cache, u32 id1, u32 id2);
+GJK_PairState *gjk_pair_cache_find_or_insert(GJK_PairCache *cache,
+		u32 id1, u32 id2, bool *inserted);
+
+#endif //GJK_GJK_PAIR_CACHE_HH_
@@ -0,0 +1,604 @@
+#include "gjk_world.hh"
+#include "gjk_manifold.hh"
+#include "thread.hh"
+
+// NOTE: Ranges smaller than this aren't worth a job of their own.
+#define GJK_WORLD_BODY_GRAIN 64
+#define GJK_WORLD_PAIR_GRAIN 32
+
+// NOTE: Number of sweep candidates whose filters are tested together.
+// At most 32 so the results fit in a u32.
+#define GJK_WORLD_FILTER_RUN 32
+
+GJK_World gjk_world_create(i32 max_bodies, f32 margin){
+	ASSERT(max_bodies > 0);
+	GJK_World result = {};
+	result.num_bodies = 0;
+	result.max_bodies = max_bodies;
+	result.bodies = (GJK_Body*)malloc(sizeof(GJK_Body) * max_bodies);
+	result.sorted = (i32*)malloc(sizeof(i32) * max_bodies);
+	result.sorted_bounds = (AABB*)malloc(sizeof(AABB) * max_bodies);
+	result.sorted_categories = (u64*)malloc(sizeof(u64) * max_bodies);
+	result.sorted_masks = (u64*)malloc(sizeof(u64) * max_bodies);
+	result.sorted_groups = (i32*)malloc(sizeof(i32) * max_bodies);
+	result.margin = margin;
+	result.linear_tolerance = GJK_WORLD_LINEAR_TOLERANCE;
+	result.angular_tolerance = GJK_WORLD_ANGULAR_TOLERANCE;
+
+	// NOTE: The cache is grown to fit the pairs before each narrowphase.
+	result.pair_cache = gjk_pair_cache_init(1024, false, 4);
+
+	result.num_buffers = 0;
+	result.buffers = NULL;
+	result.num_moved_bodies = 0;
+	result.broadphase_valid = false;
+
+	result.num_pairs = 0;
+	result.max_pairs = 4 * max_bodies;
+	result.pairs = (GJK_BodyPair*)malloc(sizeof(GJK_BodyPair) * result.max_pairs);
+	result.pairs_temp = (GJK_BodyPair*)malloc(sizeof(GJK_BodyPair) * result.max_pairs);
+	result.num_contacts = 0;
+	result.contacts = (GJK_WorldContact*)malloc(sizeof(GJK_WorldContact) * result.max_pairs);
+	result.num_filtered_pairs = 0;
+	result.num_reused_pairs = 0;
+
+	result.island_parent = (i32*)malloc(sizeof(i32) * max_bodies);
+	result.island_awake = (bool*)malloc(sizeof(bool) * max_bodies);
+	result.num_islands = 0;
+	result.num_sleeping_bodies = 0;
+	ASSERT(result.bodies != NULL && result.sorted != NULL
+		&& result.sorted_bounds != NULL && result.sorted_categories != NULL
+		&& result.sorted_masks != NULL && result.sorted_groups != NULL && result.pairs != NULL
+		&& result.pairs_temp != NULL && result.contacts != NULL
+		&& result.island_parent != NULL && result.island_awake != NULL);
+	return result;
+}
+
+void gjk_world_free(GJK_World *world){
+	for(i32 i = 0; i < world->num_bodies; i += 1)
+		free(world->bodies[i].world.points);
+	free(world->bodies);
+	free(world->sorted);
+	free(world->sorted_bounds);
+	free(world->sorted_categories);
+	free(world->sorted_masks);
+	free(world->sorted_groups);
+	for(i32 i = 0; i < world->num_buffers; i += 1)
+		free(world->buffers[i].pairs);
+	free(world->buffers);
+	free(world->pairs);
+	free(world->pairs_temp);
+	free(world->contacts);
+	free(world->island_parent);
+	free(world->island_awake);
+	gjk_pair_cache_free(&world->pair_cache);
+	memset(world, 0, sizeof(GJK_World));
+}
+
+i32 gjk_world_add_body(GJK_World *world, GJK_Polygon *local, const Transform &transform){
+	ASSERT(world->num_bodies < world->max_bodies);
+	i32 index = world->num_bodies;
+	GJK_Body *body = &world->bodies[index];
+	body->local = *local;
+	body->transform = transform;
+
+	Vector3 *world_points = (Vector3*)malloc(sizeof(Vector3) * local->num_points);
+	ASSERT(world_points != NULL);
+	body->world = make_gjk_polygon(world_points, local->num_points);
+	body->world.id = (u32)index;
+	body->world_transform = transform;
+	body->bounds = make_aabb(v3_zero, v3_zero);
+	body->version = 0;
+	body->filter = make_gjk_filter(1, GJK_FILTER_ALL, 0);
+	body->rest_steps = 0;
+	body->island = index;
+	body->sleeping = false;
+	world->num_bodies += 1;
+	world->broadphase_valid = false;
+	return index;
+}
+
+void gjk_world_set_transform(GJK_World *world, i32 body, const Transform &transform){
+	ASSERT(body >= 0 && body < world->num_bodies);
+	world->bodies[body].transform = transform;
+}
+
+void gjk_world_set_filter(GJK_World *world, i32 body, const GJK_Filter &filter){
+	ASSERT(body >= 0 && body < world->num_bodies);
+	world->bodies[body].filter = filter;
+	world->broadphase_valid = false;
+}
+
+// ----------------------------------------------------------------
+// Phases
+// ----------------------------------------------------------------
+struct GJK_WorldStep{
+	GJK_World *world;
+	JobSystem *jobs;
+	JobCounter bounds_done;
+	JobCounter broadphase_done;
+	JobCounter narrowphase_done;
+	JobCounter manifold_done;
+	bool skip_broadphase;
+
+	// NOTE: Set by the first job of each phase, and at the end of the
+	// step for the last one.
+	f64 phase_start[GJK_WORLD_NUM_PHASES + 1];
+};
+
+// NOTE: World points of quantized bodies are dequantized so their error
+// is added to the margins instead (see `GJK_Quantized`).
+static INLINE
+f32 gjk_body_error(GJK_Body *body){
+	return v3_norm(gjk_polygon_error(&body->local));
+}
+
+static INLINE
+bool gjk_body_moved(GJK_Body *body, f32 linear_tolerance2, f32 angular_tolerance){
+	if(body->version == 0)
+		return true;
+	Vector3 dp = body->transform.translation - body->world_transform.translation;
+	f32 dot = quat_dot(body->transform.rotation, body->world_transform.rotation);
+	return v3_norm2(dp) > linear_tolerance2
+		|| (1.0f - f32_abs(dot)) > angular_tolerance;
+}
+
+static
+void gjk_world_bounds_job(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_WorldStep *step = (GJK_WorldStep*)arg;
+	GJK_World *world = step->world;
+	f32 linear_tolerance2 = world->linear_tolerance * world->linear_tolerance;
+	// NOTE: The dot product of two unit quaternions is the cosine of half
+	// the angle between them.
+	f32 angular_tolerance = 1.0f - cosf(0.5f * world->angular_tolerance);
+	i32 num_moved = 0;
+	for(i32 i = begin; i < end; i += 1){
+		GJK_Body *body = &world->bodies[i];
+		if(!gjk_body_moved(body, linear_tolerance2, angular_tolerance)){
+			if(body->rest_steps < GJK_WORLD_SLEEP_STEPS)
+				body->rest_steps += 1;
+			continue;
+		}
+
+		GJK_Polygon *local = &body->local;
+		Vector3 *points = body->world.points;
+		if(gjk_polygon_is_packed(local)){
+			transform_points(body->transform, local->points, points, local->num_points);
+		}else{
+			for(i32 j = 0; j < local->num_points; j += 1)
+				points[j] = transform_point(body->transform, gjk_polygon_point(local, j));
+		}
+
+		AABB bounds = make_aabb(points[0], points[0]);
+		for(i32 j = 1; j < local->num_points; j += 1)
+			bounds = aabb_union(bounds, make_aabb(points[j], points[j]));
+
+		// NOTE: Half the margin on each body is enough for pairs within
+		// `margin` of each other to have overlapping bounds.
+		f32 expand = 0.5f * world->margin + gjk_body_error(body);
+		Vector3 e = make_v3(expand, expand, expand);
+		body->bounds = make_aabb(bounds.min - e, bounds.max + e);
+
+		// NOTE: Zero is reserved for bodies that were never updated.
+		body->world_transform = body->transform;
+		body->version += 1;
+		if(body->version == 0)
+			body->version = 1;
+		body->rest_steps = 0;
+		num_moved += 1;
+	}
+	world->buffers[worker].num_moved += num_moved;
+}
+
+struct GJK_SortKey{
+	f32 min_x;
+	i32 body;
+};
+
+static
+int gjk_sort_key_compare(const void *a, const void *b){
+	const GJK_SortKey *ka = (const GJK_SortKey*)a;
+	const GJK_SortKey *kb = (const GJK_SortKey*)b;
+	if(ka->min_x != kb->min_x)
+		return ka->min_x < kb->min_x ? -1 : 1;
+	return ka->body - kb->body;
+}
+
+static
+void gjk_world_sweep_job(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_WorldStep *step = (GJK_WorldStep*)arg;
+	GJK_World *world = step->world;
+	i32 *sorted = world->sorted;
+
+	// NOTE: Work on a copy so other workers' buffers next to this one
+	// aren't written to on every pair.
+	GJK_WorldBuffer buffer = world->buffers[worker];
+	AABB *bounds = world->sorted_bounds;
+	u64 *categories = world->sorted_categories;
+	u64 *masks = world->sorted_masks;
+	i32 *groups = world->sorted_groups;
+	i32 num_bodies = world->num_bodies;
+	for(i32 i = begin; i < end; i += 1){
+		AABB a = bounds[i];
+		u64 category = categories[i];
+		u64 mask = masks[i];
+		i32 group = groups[i];
+		for(i32 run = i + 1; run < num_bodies; run += GJK_WORLD_FILTER_RUN){
+			// NOTE: Find how much of the next run overlaps in x, then test
+			// the filters of all of it without branches (same as
+			// `gjk_filter_test`) so that loop can be vectorized.
+			i32 run_max = i32_min(run + GJK_WORLD_FILTER_RUN, num_bodies);
+			i32 run_end = run;
+			while(run_end < run_max && bounds[run_end].min.x <= a.max.x)
+				run_end += 1;
+
+			u32 accepted = 0;
+			for(i32 j = run; j < run_end; j += 1){
+				bool same_group = groups[j] == group && group != 0;
+				bool masked = (category & masks[j]) != 0 && (categories[j] & mask) != 0;
+				bool accept = same_group ? group > 0 : masked;
+				accepted |= (u32)accept << (j - run);
+			}
+
+			for(i32 j = run; j < run_end; j += 1){
+				AABB *b = &bounds[j];
+				if(b->min.y > a.max.y || b->max.y < a.min.y
+				|| b->min.z > a.max.z || b->max.z < a.min.z)
+					continue;
+				if((accepted & (1u << (j - run))) == 0){
+					buffer.num_filtered += 1;
+					continue;
+				}
+
+				if(buffer.num_pairs == buffer.max_pairs){
+					buffer.max_pairs = buffer.max_pairs > 0 ? buffer.max_pairs * 2 : 1024;
+					buffer.pairs = (GJK_BodyPair*)realloc(buffer.pairs,
+						sizeof(GJK_BodyPair) * buffer.max_pairs);
+					ASSERT(buffer.pairs != NULL);
+				}
+				i32 body1 = sorted[i];
+				i32 body2 = sorted[j];
+				GJK_BodyPair *pair = &buffer.pairs[buffer.num_pairs];
+				pair->body1 = i32_min(body1, body2);
+				pair->body2 = i32_max(body1, body2);
+				buffer.num_pairs += 1;
+			}
+			if(run_end < run_max)
+				break;
+		}
+	}
+	world->buffers[worker] = buffer;
+}
+
+static
+void gjk_world_sort_job(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_WorldStep *step = (GJK_WorldStep*)arg;
+	GJK_World *world = step->world;
+	step->phase_start[GJK_WORLD_PHASE_BROADPHASE] = thread_time();
+	i32 num_moved = 0;
+	for(i32 i = 0; i < world->num_buffers; i += 1)
+		num_moved += world->buffers[i].num_moved;
+	world->num_moved_bodies = num_moved;
+	if(num_moved == 0 && world->broadphase_valid){
+		// NOTE: Nothing moved so the pairs from the last step are still
+		// the right ones.
+		step->skip_broadphase = true;
+		return;
+	}
+
+	i32 num_bodies = world->num_bodies;
+	GJK_SortKey *keys = (GJK_SortKey*)malloc(sizeof(GJK_SortKey) * num_bodies);
+	ASSERT(keys != NULL);
+	for(i32 i = 0; i < num_bodies; i += 1){
+		keys[i].min_x = world->bodies[i].bounds.min.x;
+		keys[i].body = i;
+	}
+	qsort(keys, (usize)num_bodies, sizeof(GJK_SortKey), gjk_sort_key_compare);
+	for(i32 i = 0; i < num_bodies; i += 1){
+		GJK_Body *body = &world->bodies[keys[i].body];
+		world->sorted[i] = keys[i].body;
+		world->sorted_bounds[i] = body->bounds;
+		world->sorted_categories[i] = body->filter.category;
+		world->sorted_masks[i] = body->filter.mask;
+		world->sorted_groups[i] = body->filter.group;
+	}
+	free(keys);
+
+	job_parallel_for(step->jobs, num_bodies, GJK_WORLD_BODY_GRAIN,
+		gjk_world_sweep_job, step, &step->broadphase_done, NULL);
+}
+
+static
+void gjk_world_narrowphase_job(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_WorldStep *step = (GJK_WorldStep*)arg;
+	GJK_World *world = step->world;
+	for(i32 i = begin; i < end; i += 1){
+		GJK_BodyPair *pair = &world->pairs[i];
+		GJK_Body *body1 = &world->bodies[pair->body1];
+		GJK_Body *body2 = &world->bodies[pair->body2];
+		f32 margin = world->margin + gjk_body_error(body1) + gjk_body_error(body2);
+
+		bool inserted;
+		GJK_PairState *state = gjk_pair_cache_find_or_insert(&world->pair_cache,
+			body1->world.id, body2->world.id, &inserted);
+		if(state != NULL && inserted)
+			gjk_persistent_manifold_reset(&state->manifold);
+
+		bool reused = state != NULL
+			&& state->version1 == body1->version
+			&& state->version2 == body2->version;
+		GJK_Result result;
+		if(reused){
+			result = state->result;
+		}else{
+			result = gjk(&body1->world, &body2->world);
+			if(state != NULL){
+				state->overlap = result.overlap;
+				state->distance = result.distance;
+				state->version1 = body1->version;
+				state->version2 = body2->version;
+				state->result = result;
+			}
+		}
+
+		// NOTE: Pairs that aren't contacts are marked with a negative
+		// body and removed in `gjk_world_start_manifold`.
+		GJK_WorldContact *contact = &world->contacts[i];
+		contact->body1 = (result.overlap || result.distance <= margin) ? pair->body1 : -1;
+		contact->body2 = pair->body2;
+		contact->result = result;
+		contact->state = state;
+		contact->margin = margin;
+		contact->reused = reused;
+	}
+}
+
+static
+void gjk_world_manifold_job(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_WorldStep *step = (GJK_WorldStep*)arg;
+	GJK_World *world = step->world;
+	for(i32 i = begin; i < end; i += 1){
+		GJK_WorldContact *contact = &world->contacts[i];
+		if(contact->state == NULL || contact->reused)
+			continue;
+		GJK_Body *body1 = &world->bodies[contact->body1];
+		GJK_Body *body2 = &world->bodies[contact->body2];
+		gjk_persistent_manifold_collide_with_result(&contact->state->manifold,
+			&body1->world, body1->world_transform,
+			&body2->world, body2->world_transform,
+			&contact->result, contact->margin);
+	}
+}
+
+// NOTE: Stable LSD radix sort by (body1, body2), 8 bits at a time. Only
+// the digits that can be non zero for `num_bodies` are sorted. The
+// result ends up in `pairs`.
+static
+void gjk_world_sort_pairs(GJK_BodyPair *pairs, GJK_BodyPair *temp,
+		i32 num_pairs, i32 num_bodies){
+	i32 num_digits = 0;
+	while(num_digits < 4 && ((u32)(num_bodies - 1) >> (8 * num_digits)) != 0)
+		num_digits += 1;
+
+	GJK_BodyPair *src = pairs;
+	GJK_BodyPair *dst = temp;
+	for(i32 pass = 0; pass < (2 * num_digits); pass += 1){
+		bool first = pass < num_digits;
+		u32 shift = (u32)(8 * (first ? pass : (pass - num_digits)));
+
+		u32 offsets[256] = {};
+		for(i32 i = 0; i < num_pairs; i += 1){
+			u32 body = (u32)(first ? src[i].body2 : src[i].body1);
+			offsets[(body >> shift) & 0xFF] += 1;
+		}
+
+		// NOTE: Skip digits where all pairs fall in the same bucket.
+		u32 body0 = (u32)(first ? src[0].body2 : src[0].body1);
+		if(offsets[(body0 >> shift) & 0xFF] == (u32)num_pairs)
+			continue;
+
+		u32 sum = 0;
+		for(i32 i = 0; i < 256; i += 1){
+			u32 count = offsets[i];
+			offsets[i] = sum;
+			sum += count;
+		}
+
+		for(i32 i = 0; i < num_pairs; i += 1){
+			u32 body = (u32)(first ? src[i].body2 : src[i].body1);
+			dst[offsets[(body >> shift) & 0xFF]++] = src[i];
+		}
+
+		GJK_BodyPair *swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if(src != pairs)
+		memcpy(pairs, src, sizeof(GJK_BodyPair) * num_pairs);
+}
+
+// NOTE: The number of pairs and contacts is only known once the previous
+// phase is done so these run as single jobs that start the parallel
+// part. They count towards the same counter so it can't reach zero
+// before the parallel part is queued.
+static
+void gjk_world_start_narrowphase(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_WorldStep *step = (GJK_WorldStep*)arg;
+	GJK_World *world = step->world;
+	step->phase_start[GJK_WORLD_PHASE_NARROWPHASE] = thread_time();
+	if(step->skip_broadphase){
+		job_parallel_for(step->jobs, world->num_pairs, GJK_WORLD_PAIR_GRAIN,
+			gjk_world_narrowphase_job, step, &step->narrowphase_done, NULL);
+		return;
+	}
+
+	i32 num_pairs = 0;
+	i32 num_filtered = 0;
+	for(i32 i = 0; i < world->num_buffers; i += 1){
+		num_pairs += world->buffers[i].num_pairs;
+		num_filtered += world->buffers[i].num_filtered;
+	}
+	world->num_filtered_pairs = num_filtered;
+
+	if(num_pairs > world->max_pairs){
+		while(num_pairs > world->max_pairs)
+			world->max_pairs *= 2;
+		free(world->pairs);
+		free(world->pairs_temp);
+		free(world->contacts);
+		world->pairs = (GJK_BodyPair*)malloc(sizeof(GJK_BodyPair) * world->max_pairs);
+		world->pairs_temp = (GJK_BodyPair*)malloc(sizeof(GJK_BodyPair) * world->max_pairs);
+		world->contacts = (GJK_WorldContact*)malloc(sizeof(GJK_WorldContact) * world->max_pairs);
+		ASSERT(world->pairs != NULL && world->pairs_temp != NULL
+			&& world->contacts != NULL);
+	}
+
+	// NOTE: Which worker found which pair depends on scheduling, the set
+	// of pairs doesn't. Sorting them makes the order independent of it.
+	GJK_BodyPair *pairs = world->pairs;
+	for(i32 i = 0; i < world->num_buffers; i += 1){
+		GJK_WorldBuffer *buffer = &world->buffers[i];
+		memcpy(pairs, buffer->pairs, sizeof(GJK_BodyPair) * buffer->num_pairs);
+		pairs += buffer->num_pairs;
+	}
+	world->num_pairs = num_pairs;
+	world->broadphase_valid = true;
+	if(num_pairs > 0){
+		gjk_world_sort_pairs(world->pairs, world->pairs_temp,
+			num_pairs, world->num_bodies);
+	}
+
+	// NOTE: Otherwise, which pairs get no cached state when the cache is
+	// full would depend on scheduling too.
+	gjk_pair_cache_reserve(&world->pair_cache, (u32)num_pairs);
+
+	job_parallel_for(step->jobs, num_pairs, GJK_WORLD_PAIR_GRAIN,
+		gjk_world_narrowphase_job, step, &step->narrowphase_done, NULL);
+}
+
+static INLINE
+i32 gjk_island_find(i32 *parent, i32 body){
+	while(parent[body] != body){
+		parent[body] = parent[parent[body]];
+		body = parent[body];
+	}
+	return body;
+}
+
+// NOTE: Union find over the contacts. Roots are always the smallest body
+// index in the island so islands don't depend on the contact order.
+static
+void gjk_world_update_islands(GJK_World *world){
+	i32 num_bodies = world->num_bodies;
+	i32 *parent = world->island_parent;
+	bool *awake = world->island_awake;
+	for(i32 i = 0; i < num_bodies; i += 1){
+		parent[i] = i;
+		awake[i] = false;
+	}
+
+	for(i32 i = 0; i < world->num_contacts; i += 1){
+		GJK_WorldContact *contact = &world->contacts[i];
+		i32 root1 = gjk_island_find(parent, contact->body1);
+		i32 root2 = gjk_island_find(parent, contact->body2);
+		if(root1 < root2)
+			parent[root2] = root1;
+		else if(root2 < root1)
+			parent[root1] = root2;
+	}
+
+	i32 num_islands = 0;
+	for(i32 i = 0; i < num_bodies; i += 1){
+		GJK_Body *body = &world->bodies[i];
+		body->island = gjk_island_find(parent, i);
+		if(body->island == i)
+			num_islands += 1;
+		if(body->rest_steps < GJK_WORLD_SLEEP_STEPS)
+			awake[body->island] = true;
+	}
+
+	i32 num_sleeping = 0;
+	for(i32 i = 0; i < num_bodies; i += 1){
+		GJK_Body *body = &world->bodies[i];
+		body->sleeping = !awake[body->island];
+		if(body->sleeping)
+			num_sleeping += 1;
+	}
+	world->num_islands = num_islands;
+	world->num_sleeping_bodies = num_sleeping;
+}
+
+static
+void gjk_world_start_manifold(void *arg, i32 begin, i32 end, i32 worker){
+	GJK_WorldStep *step = (GJK_WorldStep*)arg;
+	GJK_World *world = step->world;
+	step->phase_start[GJK_WORLD_PHASE_MANIFOLD] = thread_time();
+	i32 num_contacts = 0;
+	i32 num_reused = 0;
+	for(i32 i = 0; i < world->num_pairs; i += 1){
+		if(world->contacts[i].reused)
+			num_reused += 1;
+		if(world->contacts[i].body1 < 0)
+			continue;
+		world->contacts[num_contacts] = world->contacts[i];
+		num_contacts += 1;
+	}
+	world->num_contacts = num_contacts;
+	world->num_reused_pairs = num_reused;
+	gjk_world_update_islands(world);
+
+	job_parallel_for(step->jobs, num_contacts, GJK_WORLD_PAIR_GRAIN,
+		gjk_world_manifold_job, step, &step->manifold_done, NULL);
+}
+
+void gjk_world_step(GJK_World *world, JobSystem *jobs){
+	i32 num_workers = job_system_num_workers(jobs);
+	if(world->num_buffers < num_workers){
+		world->buffers = (GJK_WorldBuffer*)realloc(world->buffers,
+			sizeof(GJK_WorldBuffer) * num_workers);
+		ASSERT(world->buffers != NULL);
+		for(i32 i = world->num_buffers; i < num_workers; i += 1){
+			world->buffers[i].max_pairs = 0;
+			world->buffers[i].pairs = NULL;
+		}
+		world->num_buffers = num_workers;
+	}
+	for(i32 i = 0; i < world->num_buffers; i += 1){
+		world->buffers[i].num_pairs = 0;
+		world->buffers[i].num_filtered = 0;
+		world->buffers[i].num_moved = 0;
+	}
+
+	gjk_pair_cache_begin_frame(&world->pair_cache);
+	world->num_contacts = 0;
+	world->num_reused_pairs = 0;
+	if(world->num_bodies == 0){
+		world->num_pairs = 0;
+		world->num_filtered_pairs = 0;
+		world->num_moved_bodies = 0;
+		world->num_islands = 0;
+		world->num_sleeping_bodies = 0;
+		for(i32 i = 0; i < GJK_WORLD_NUM_PHASES; i += 1)
+			world->phase_times[i] = 0.0;
+		return;
+	}
+
+	GJK_WorldStep step = {};
+	step.world = world;
+	step.jobs = jobs;
+	step.phase_start[GJK_WORLD_PHASE_BOUNDS] = thread_time();
+	job_parallel_for(jobs, world->num_bodies, GJK_WORLD_BODY_GRAIN,
+		gjk_world_bounds_job, &step, &step.bounds_done, NULL);
+	job_submit(jobs, gjk_world_sort_job, &step,
+		&step.broadphase_done, &step.bounds_done);
+	job_submit(jobs, gjk_world_start_narrowphase, &step,
+		&step.narrowphase_done, &step.broadphase_done);
+	job_submit(jobs, gjk_world_start_manifold, &step,
+		&step.manifold_done, &step.narrowphase_done);
+	job_wait(jobs, &step.manifold_done);
+
+	step.phase_start[GJK_WORLD_NUM_PHASES] = thread_time();
+	for(i32 i = 0; i < GJK_WORLD_NUM_PHASES; i += 1)
+		world->phase_times[i] = step.phase_start[i + 1] - step.phase_start[i];
+}
@@ -0,0 +1,203 @@
+#ifndef GJK_GJK_WORLD_HH_
+#define GJK_GJK_WORLD_HH_ 1
+
+#include "common.hh"
+#include "math.hh"
+#include "gjk.hh"
+#include "gjk_pair_cache.hh"
+#include "jobs.hh"
+
+// NOTE: A set of convex bodies and the collision step over them. Each
+// step runs four phases as jobs, each one depending on the previous:
+//	1. bounds: move the body points into world space and update their
+//	AABB (parallel over bodies).
+//	2. broadphase: sort the AABBs along X and sweep for overlapping
+//	pairs (the sweep is parallel over bodies).
+//	3. narrowphase: run `gjk` on each pair (parallel over pairs) and
+//	keep the ones within `margin` as contacts.
+//	4. manifold: update the persistent manifold of each contact
+//	(parallel over contacts).
+//
+//	Pair state (separating axis and manifold) is kept in a pair cache
+// keyed by body index.
+//
+//	Bodies only move, as far as the step is concerned, when their
+// transform gets further than the motion tolerances from the one their
+// world points were computed with. Their `version` is bumped then and
+// pairs whose bodies kept their versions reuse the last result and
+// manifold without calling `gjk`. If no body moved and no filter changed
+// the broadphase is skipped too, so idle scenes only pay for a pass over
+// the bodies and the pairs.
+//
+//	Bodies touching each other (directly or through other bodies) form
+// an island. Islands where no body moved for `GJK_WORLD_SLEEP_STEPS`
+// steps are put to sleep and wake up as soon as one of their bodies
+// moves. Sleeping is reported but nothing else depends on it here since
+// the world doesn't move bodies on its own.
+//
+//	The output doesn't depend on the number of threads or how the jobs
+// were scheduled. Workers write pairs to their own buffers which are
+// merged and radix sorted by pair and narrowphase results are written
+// by pair index, so no locks or atomics are needed per pair.
+
+// NOTE: Collision filter. Two bodies in the same non zero group always
+// collide if the group is positive and never if it's negative. Otherwise
+// they collide if each one's category is in the other's mask. Filtered
+// pairs are dropped in the broadphase before any gjk call.
+#define GJK_FILTER_ALL 0xFFFFFFFFFFFFFFFFULL
+
+struct GJK_Filter{
+	u64 category;
+	u64 mask;
+	i32 group;
+};
+
+static INLINE
+GJK_Filter make_gjk_filter(u64 category, u64 mask, i32 group){
+	GJK_Filter result;
+	result.category = category;
+	result.mask = mask;
+	result.group = group;
+	return result;
+}
+
+static INLINE
+bool gjk_filter_test(const GJK_Filter &a, const GJK_Filter &b){
+	if(a.group == b.group && a.group != 0)
+		return a.group > 0;
+	return (a.category & b.mask) != 0 && (b.category & a.mask) != 0;
+}
+
+#define GJK_WORLD_PHASE_BOUNDS 0
+#define GJK_WORLD_PHASE_BROADPHASE 1
+#define GJK_WORLD_PHASE_NARROWPHASE 2
+#define GJK_WORLD_PHASE_MANIFOLD 3
+#define GJK_WORLD_NUM_PHASES 4
+
+#define GJK_WORLD_SLEEP_STEPS 60
+#define GJK_WORLD_LINEAR_TOLERANCE 1.0e-4f
+#define GJK_WORLD_ANGULAR_TOLERANCE 2.0e-3f
+
+struct GJK_Body{
+	GJK_Polygon local;
+	Transform transform;
+
+	// NOTE: Owned world space copy of `local` and its bounds. The margin
+	// is already included in `bounds`. `world_transform` is the transform
+	// they were computed with and `version` is bumped every time they are
+	// recomputed (it starts at zero for bodies that were never updated).
+	GJK_Polygon world;
+	Transform world_transform;
+	AABB bounds;
+	u32 version;
+
+	GJK_Filter filter;
+
+	// NOTE: Number of steps since the body last moved, and the island
+	// (the index of one of its bodies) it was in on the last step.
+	i32 rest_steps;
+	i32 island;
+	bool sleeping;
+};
+
+struct GJK_BodyPair{
+	i32 body1;
+	i32 body2;
+};
+
+struct GJK_WorldContact{
+	i32 body1;
+	i32 body2;
+	GJK_Result result;
+	GJK_PairState *state;
+
+	// NOTE: `GJK_World::margin` plus the quantization error of both
+	// bodies, the margin the contact was accepted with.
+	f32 margin;
+
+	// NOTE: Neither body moved since the last step so `result` and the
+	// manifold in `state` are the cached ones.
+	bool reused;
+};
+
+// NOTE: Pairs found by one worker during the sweep. Only that worker
+// touches it so it grows as needed without locks.
+struct GJK_WorldBuffer{
+	i32 num_pairs;
+	i32 max_pairs;
+	GJK_BodyPair *pairs;
+	i32 num_filtered;
+	i32 num_moved;
+};
+
+struct GJK_World{
+	i32 num_bodies;
+	i32 max_bodies;
+	GJK_Body *bodies;
+	f32 margin;
+
+	// NOTE: Motion tolerances (distance and angle in radians), initialized
+	// to GJK_WORLD_LINEAR_TOLERANCE and GJK_WORLD_ANGULAR_TOLERANCE.
+	f32 linear_tolerance;
+	f32 angular_tolerance;
+
+	GJK_PairCache pair_cache;
+
+	// NOTE: Broadphase. Bodies sorted by `bounds.min.x` (then by index)
+	// with their bounds and filter fields copied in the same order so the
+	// sweep reads them sequentially, and one output buffer per worker.
+	// The filter fields are split so a run of candidates can be tested
+	// together.
+	i32 *sorted;
+	AABB *sorted_bounds;
+	u64 *sorted_categories;
+	u64 *sorted_masks;
+	i32 *sorted_groups;
+	i32 num_buffers;
+	GJK_WorldBuffer *buffers;
+	i32 num_moved_bodies;
+	bool broadphase_valid;
+
+	// NOTE: The worker buffers merged and sorted by (body1, body2) so the
+	// pairs are the same, in the same order, for any number of threads.
+	i32 num_pairs;
+	i32 max_pairs;
+	GJK_BodyPair *pairs;
+	GJK_BodyPair *pairs_temp;
+	i32 num_filtered_pairs;
+
+	// NOTE: Narrowphase output. There is one slot per pair which is then
+	// compacted so contacts keep the pair order.
+	i32 num_contacts;
+	GJK_WorldContact *contacts;
+	i32 num_reused_pairs;
+
+	// NOTE: Islands, built from the contacts with union find.
+	i32 *island_parent;
+	bool *island_awake;
+	i32 num_islands;
+	i32 num_sleeping_bodies;
+
+	// NOTE: Wall time of each phase (GJK_WORLD_PHASE_*) on the last step
+	// in seconds. A phase starts when the previous one is done so they
+	// add up to the whole step.
+	f64 phase_times[GJK_WORLD_NUM_PHASES];
+};
+
+GJK_World gjk_world_create(i32 max_bodies, f32 margin);
+void gjk_world_free(GJK_World *world);
+
+// NOTE: `local` is referenced (see `make_gjk_polygon`) and its world
+// points are allocated here. Returns the body index.
+i32 gjk_world_add_body(GJK_World *world, GJK_Polygon *local, const Transform &transform);
+void gjk_world_set_transform(GJK_World *world, i32 body, const Transform &transform);
+
+// NOTE: Bodies are added with `make_gjk_filter(1, GJK_FILTER_ALL, 0)`.
+void gjk_world_set_filter(GJK_World *world, i32 body, const GJK_Filter &filter);
+
+// NOTE: Runs all phases. `jobs` may be NULL to run them on the calling
+// thread. Contacts are in `world->contacts[0 .. world->num_contacts)`
+// until the next step.
+void gjk_world_step(GJK_World *world, JobSystem *jobs);
+
+#endif //GJK_GJK_WORLD_HH_
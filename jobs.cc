@@ -0,0 +1,356 @@
+#include "jobs.hh"
+#include "thread.hh"
+
+// NOTE: Idle workers spin for a while before going to sleep since new
+// jobs usually show up right after the previous phase ends.
+#define JOB_IDLE_SPINS 2048
+
+struct JobQueue{
+	volatile u32 lock;
+	volatile u32 head;
+	volatile u32 tail;
+	Job jobs[JOB_QUEUE_SIZE];
+};
+
+struct JobWorker;
+
+struct JobSystem{
+	i32 num_workers;
+	JobWorker *workers;
+
+	Semaphore *wakeup;
+	volatile u32 num_sleeping;
+	volatile u32 num_queued;
+	volatile u32 quit;
+};
+
+struct JobWorker{
+	JobSystem *system;
+	i32 index;
+	u32 rng_state;
+	Thread *thread;
+	JobQueue queue;
+};
+
+static THREAD_LOCAL JobSystem *job_current_system;
+static THREAD_LOCAL i32 job_current_worker;
+
+static INLINE
+void job_lock(volatile u32 *lock){
+	while(atomic_cas_u32(lock, 0, 1) != 0){
+		while(atomic_load_u32(lock) != 0)
+			cpu_pause();
+	}
+}
+
+static INLINE
+void job_unlock(volatile u32 *lock){
+	atomic_store_u32(lock, 0);
+}
+
+// ----------------------------------------------------------------
+// Queues
+// ----------------------------------------------------------------
+static
+bool job_queue_push(JobQueue *queue, const Job *job){
+	bool result = false;
+	job_lock(&queue->lock);
+	if((queue->tail - queue->head) < JOB_QUEUE_SIZE){
+		queue->jobs[queue->tail & (JOB_QUEUE_SIZE - 1)] = *job;
+		atomic_store_u32(&queue->tail, queue->tail + 1);
+		result = true;
+	}
+	job_unlock(&queue->lock);
+	return result;
+}
+
+static
+bool job_queue_pop(JobQueue *queue, Job *job){
+	bool result = false;
+	job_lock(&queue->lock);
+	if(queue->tail != queue->head){
+		atomic_store_u32(&queue->tail, queue->tail - 1);
+		*job = queue->jobs[queue->tail & (JOB_QUEUE_SIZE - 1)];
+		result = true;
+	}
+	job_unlock(&queue->lock);
+	return result;
+}
+
+static
+bool job_queue_steal(JobQueue *queue, Job *job){
+	// NOTE: Peek without the lock first so idle workers don't keep
+	// taking the locks of empty queues.
+	if(atomic_load_u32(&queue->tail) == atomic_load_u32(&queue->head))
+		return false;
+
+	bool result = false;
+	job_lock(&queue->lock);
+	if(queue->tail != queue->head){
+		*job = queue->jobs[queue->head & (JOB_QUEUE_SIZE - 1)];
+		atomic_store_u32(&queue->head, queue->head + 1);
+		result = true;
+	}
+	job_unlock(&queue->lock);
+	return result;
+}
+
+// ----------------------------------------------------------------
+// Scheduling
+// ----------------------------------------------------------------
+static void job_execute(JobSystem *jobs, Job *job);
+
+static
+void job_push(JobSystem *jobs, const Job *job){
+	if(jobs == NULL){
+		Job tmp = *job;
+		job_execute(NULL, &tmp);
+		return;
+	}
+
+	ASSERT(job_current_system == jobs);
+	JobWorker *worker = &jobs->workers[job_current_worker];
+	if(!job_queue_push(&worker->queue, job)){
+		// NOTE: The queue is full so there is plenty of work around
+		// already. Running it here is always correct.
+		Job tmp = *job;
+		job_execute(jobs, &tmp);
+		return;
+	}
+
+	atomic_add_u32(&jobs->num_queued, 1);
+	if(atomic_add_u32(&jobs->num_sleeping, 0) > 0)
+		semaphore_post(jobs->wakeup, 1);
+}
+
+static
+void job_counter_finish(JobSystem *jobs, JobCounter *counter){
+	if(counter == NULL)
+		return;
+
+	// NOTE: Only the last job takes the lock. It drops the counter to zero
+	// while holding it so `job_wait` can tell when we're done touching the
+	// counter (see below) and dependents added after this point see the
+	// counter at zero and queue themselves (see `job_depend`).
+	while(true){
+		u32 value = atomic_load_u32(&counter->value);
+		ASSERT(value > 0);
+		if(value == 1)
+			break;
+		if(atomic_cas_u32(&counter->value, value, value - 1) == value)
+			return;
+	}
+
+	Job dependents[JOB_MAX_DEPENDENTS];
+	i32 num_dependents = 0;
+	job_lock(&counter->lock);
+	if(atomic_add_u32(&counter->value, (u32)-1) == 1){
+		num_dependents = counter->num_dependents;
+		for(i32 i = 0; i < num_dependents; i += 1)
+			dependents[i] = counter->dependents[i];
+		counter->num_dependents = 0;
+	}
+	job_unlock(&counter->lock);
+
+	for(i32 i = 0; i < num_dependents; i += 1)
+		job_push(jobs, &dependents[i]);
+}
+
+static
+void job_execute(JobSystem *jobs, Job *job){
+	// NOTE: Split off the back half until the range is small enough.
+	// Each half counts as its own job. There is no point in splitting
+	// without a system to run the halves in parallel.
+	while(jobs != NULL && (job->end - job->begin) > job->grain){
+		i32 mid = job->begin + (job->end - job->begin) / 2;
+		Job back = *job;
+		back.begin = mid;
+		job->end = mid;
+		if(back.counter != NULL)
+			atomic_add_u32(&back.counter->value, 1);
+		job_push(jobs, &back);
+	}
+
+	i32 worker = jobs != NULL ? job_current_worker : 0;
+	job->proc(job->arg, job->begin, job->end, worker);
+	job_counter_finish(jobs, job->counter);
+}
+
+// NOTE: Queues `job` now if `dependency` is done or makes it a dependent
+// of `dependency` otherwise.
+static
+void job_depend(JobSystem *jobs, const Job *job, JobCounter *dependency){
+	if(dependency != NULL){
+		bool deferred = false;
+		job_lock(&dependency->lock);
+		if(atomic_load_u32(&dependency->value) != 0){
+			ASSERT(dependency->num_dependents < JOB_MAX_DEPENDENTS);
+			dependency->dependents[dependency->num_dependents] = *job;
+			dependency->num_dependents += 1;
+			deferred = true;
+		}
+		job_unlock(&dependency->lock);
+		if(deferred)
+			return;
+	}
+	job_push(jobs, job);
+}
+
+static
+bool job_find(JobSystem *jobs, JobWorker *worker, Job *job){
+	if(job_queue_pop(&worker->queue, job))
+		return true;
+
+	// NOTE: Start stealing from a random worker so thieves spread out.
+	u32 x = worker->rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	worker->rng_state = x;
+	i32 num_workers = jobs->num_workers;
+	i32 start = (i32)(x % (u32)num_workers);
+	for(i32 i = 0; i < num_workers; i += 1){
+		i32 victim = (start + i) % num_workers;
+		if(victim != worker->index && job_queue_steal(&jobs->workers[victim].queue, job))
+			return true;
+	}
+	return false;
+}
+
+static
+bool job_run_one(JobSystem *jobs, JobWorker *worker){
+	Job job;
+	if(!job_find(jobs, worker, &job))
+		return false;
+	atomic_add_u32(&jobs->num_queued, (u32)-1);
+	job_execute(jobs, &job);
+	return true;
+}
+
+static
+void job_worker_main(void *arg){
+	JobWorker *worker = (JobWorker*)arg;
+	JobSystem *jobs = worker->system;
+	job_current_system = jobs;
+	job_current_worker = worker->index;
+
+	while(atomic_load_u32(&jobs->quit) == 0){
+		bool found = false;
+		for(i32 spin = 0; spin < JOB_IDLE_SPINS && !found; spin += 1){
+			found = job_run_one(jobs, worker);
+			if(!found)
+				cpu_pause();
+		}
+
+		if(!found){
+			// NOTE: Announce that we're going to sleep before checking
+			// for work one last time. `job_push` does the opposite so
+			// one of us always sees the other.
+			atomic_add_u32(&jobs->num_sleeping, 1);
+			if(atomic_add_u32(&jobs->num_queued, 0) == 0
+			&& atomic_load_u32(&jobs->quit) == 0)
+				semaphore_wait(jobs->wakeup);
+			atomic_add_u32(&jobs->num_sleeping, (u32)-1);
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+// API
+// ----------------------------------------------------------------
+JobSystem *job_system_create(i32 num_threads){
+	ASSERT(num_threads >= 1 && num_threads <= JOB_MAX_WORKERS);
+	ASSERT(job_current_system == NULL);
+	JobSystem *jobs = (JobSystem*)calloc(1, sizeof(JobSystem));
+	JobWorker *workers = (JobWorker*)calloc(num_threads, sizeof(JobWorker));
+	ASSERT(jobs != NULL && workers != NULL);
+	jobs->num_workers = num_threads;
+	jobs->workers = workers;
+	jobs->wakeup = semaphore_create(0);
+
+	job_current_system = jobs;
+	job_current_worker = 0;
+	for(i32 i = 0; i < num_threads; i += 1){
+		workers[i].system = jobs;
+		workers[i].index = i;
+		workers[i].rng_state = 0x9E3779B9u * (u32)(i + 1);
+		if(i > 0)
+			workers[i].thread = thread_create(job_worker_main, &workers[i]);
+	}
+	return jobs;
+}
+
+void job_system_destroy(JobSystem *jobs){
+	ASSERT(job_current_system == jobs && job_current_worker == 0);
+	atomic_store_u32(&jobs->quit, 1);
+	if(jobs->num_workers > 1)
+		semaphore_post(jobs->wakeup, jobs->num_workers - 1);
+	for(i32 i = 1; i < jobs->num_workers; i += 1)
+		thread_join(jobs->workers[i].thread);
+	semaphore_destroy(jobs->wakeup);
+	free(jobs->workers);
+	free(jobs);
+	job_current_system = NULL;
+}
+
+i32 job_system_num_workers(JobSystem *jobs){
+	return jobs != NULL ? jobs->num_workers : 1;
+}
+
+void job_submit(JobSystem *jobs, JobProc proc, void *arg,
+		JobCounter *counter, JobCounter *dependency){
+	Job job;
+	job.proc = proc;
+	job.arg = arg;
+	job.begin = 0;
+	job.end = 1;
+	job.grain = 1;
+	job.counter = counter;
+	if(counter != NULL)
+		atomic_add_u32(&counter->value, 1);
+	job_depend(jobs, &job, dependency);
+}
+
+void job_parallel_for(JobSystem *jobs, i32 count, i32 grain,
+		JobProc proc, void *arg, JobCounter *counter, JobCounter *dependency){
+	if(count <= 0)
+		return;
+
+	if(grain <= 0){
+		// NOTE: Enough chunks for each worker to steal a few times.
+		grain = count / (8 * job_system_num_workers(jobs));
+		if(grain < 1)
+			grain = 1;
+	}
+
+	Job job;
+	job.proc = proc;
+	job.arg = arg;
+	job.begin = 0;
+	job.end = count;
+	job.grain = grain;
+	job.counter = counter;
+	if(counter != NULL)
+		atomic_add_u32(&counter->value, 1);
+	job_depend(jobs, &job, dependency);
+}
+
+void job_wait(JobSystem *jobs, JobCounter *counter){
+	if(jobs == NULL){
+		ASSERT(counter == NULL || counter->value == 0);
+		return;
+	}
+
+	ASSERT(job_current_system == jobs);
+	JobWorker *worker = &jobs->workers[job_current_worker];
+	while(atomic_load_u32(&counter->value) != 0){
+		if(!job_run_one(jobs, worker))
+			cpu_pause();
+	}
+
+	// NOTE: The last job may still be holding the lock after dropping the
+	// counter to zero. The caller is free to reuse the counter once we're
+	// past it.
+	job_lock(&counter->lock);
+	job_unlock(&counter->lock);
+}
@@ -0,0 +1,71 @@
+#ifndef GJK_JOBS_HH_
+#define GJK_JOBS_HH_ 1
+
+#include "common.hh"
+
+// NOTE: Work stealing job system. Each worker has its own deque: it
+// pushes and pops jobs at the back and idle workers steal from the
+// front of the others, so big chunks of work move between workers and
+// small ones stay where they were created.
+//
+//	A job runs `proc(arg, begin, end, worker)` over a range. Ranges
+// bigger than `grain` are split in half before running, with the back
+// half pushed as a new job, which is how `job_parallel_for` adapts the
+// chunk size to how much stealing is going on.
+//
+//	Counters track groups of jobs. They are incremented when a job is
+// submitted and decremented when it finishes (including the jobs it
+// was split into). Jobs may also depend on a counter and they are only
+// queued once it reaches zero, which is how phases are chained without
+// going back to the submitting thread.
+//
+//	The thread that creates the system is worker 0 and it only runs
+// jobs from inside `job_wait`. Jobs may only be submitted from worker
+// 0 or from other jobs. A NULL system runs everything immediately on
+// the calling thread.
+#define JOB_MAX_WORKERS 64
+#define JOB_QUEUE_SIZE 4096
+#define JOB_MAX_DEPENDENTS 4
+
+struct JobCounter;
+typedef void (*JobProc)(void *arg, i32 begin, i32 end, i32 worker);
+
+struct Job{
+	JobProc proc;
+	void *arg;
+	i32 begin;
+	i32 end;
+	i32 grain;
+	JobCounter *counter;
+};
+
+// NOTE: Counters must be zero initialized and must outlive the jobs
+// (and dependents) that use them.
+struct JobCounter{
+	volatile u32 value;
+	volatile u32 lock;
+	i32 num_dependents;
+	Job dependents[JOB_MAX_DEPENDENTS];
+};
+
+struct JobSystem;
+
+// NOTE: `num_threads` includes the calling thread so `num_threads - 1`
+// threads are created.
+JobSystem *job_system_create(i32 num_threads);
+void job_system_destroy(JobSystem *jobs);
+i32 job_system_num_workers(JobSystem *jobs);
+
+// NOTE: Both `counter` and `dependency` may be NULL.
+void job_submit(JobSystem *jobs, JobProc proc, void *arg,
+		JobCounter *counter, JobCounter *dependency);
+
+// NOTE: Runs `proc` over [0, count). If `grain` is zero, it's picked
+// from `count` and the number of workers.
+void job_parallel_for(JobSystem *jobs, i32 count, i32 grain,
+		JobProc proc, void *arg, JobCounter *counter, JobCounter *dependency);
+
+// NOTE: Runs jobs until `counter` reaches zero.
+void job_wait(JobSystem *jobs, JobCounter *counter);
+
+#endif //GJK_JOBS_HH_
@@ -5,6 +5,11 @@
 #include "common.hh"
 #include "math.hh"
 #include "gjk.hh"
+#include "gjk_frustum.hh"
+#include "gjk_hull.hh"
+#include "gjk_world.hh"
+#include "jobs.hh"
+#include "thread.hh"
 
 #define WINDOW_W 800
 #define WINDOW_H 450
@@ -12,6 +17,9 @@
 static SDL_Window *window;
 static SDL_GLContext gl_context;
 
+// NOTE: Bytes written to GL buffers since startup.
+static u64 gl_bytes_uploaded;
+
 static
 void *malloc_nofail(usize size){
 	void *mem = malloc(size);
@@ -80,6 +88,8 @@ bool gl_load(void){
 			LOG_ERROR("unable to load `%s`\n", "gl"#name);			\
 			all_loaded = false;										\
 		}
+	#define GL_OPTIONAL_PROC(_1, name, _2)							\
+		gl##name = (PFN_gl##name)SDL_GL_GetProcAddress("gl"#name);
 	#include "opengl.inl"
 
 	if(!all_loaded){
@@ -97,6 +107,35 @@ bool gl_load(void){
 	return true;
 }
 
+// NOTE: Buffer storage is core since 4.4 but we only ask for 4.2 so it
+// may come from the extension. Some platforms return a pointer for any
+// name so the version or extension is checked too.
+static
+bool gl_has_buffer_storage(void){
+	if(!glBufferStorage)
+		return false;
+	GLint major, minor;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if(major > 4 || (major == 4 && minor >= 4))
+		return true;
+	return SDL_GL_ExtensionSupported("GL_ARB_buffer_storage") == SDL_TRUE;
+}
+
+static
+void gl_wait_fence(GLsync fence){
+	while(true){
+		GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			break;
+		if(status == GL_WAIT_FAILED){
+			LOG_ERROR("failed to wait on fence\n");
+			break;
+		}
+	}
+	glDeleteSync(fence);
+}
+
 #if BUILD_DEBUG
 static
 void APIENTRY gl_debug_callback(GLenum source, GLenum type, GLuint id,
@@ -125,6 +164,85 @@ void gl_init_state(void){
 	glBindVertexArray(default_vao);
 }
 
+// ----------------------------------------------------------------
+// Stream Buffer
+// ----------------------------------------------------------------
+
+// NOTE: Ring of `GL_STREAM_SEGMENTS` segments for data that changes
+// every frame. Each frame writes to the next segment, so the GPU can
+// still be reading the previous ones. With buffer storage the buffer is
+// persistently mapped and written directly, and a fence placed after
+// the draw guards each segment from being overwritten too early.
+// Otherwise only the used range is written with `glBufferSubData` and
+// the buffer is orphaned whenever the ring wraps around.
+#define GL_STREAM_SEGMENTS 3
+
+struct GLStreamBuffer{
+	GLenum target;
+	GLuint buffer;
+	usize segment_size;
+	i32 segment;
+
+	bool persistent;
+	u8 *mapped;
+	GLsync fences[GL_STREAM_SEGMENTS];
+};
+
+static
+GLStreamBuffer gl_stream_buffer_init(GLenum target, usize segment_size, bool persistent){
+	GLStreamBuffer result = {};
+	result.target = target;
+	result.segment_size = segment_size;
+	result.persistent = persistent;
+
+	usize size = GL_STREAM_SEGMENTS * segment_size;
+	glGenBuffers(1, &result.buffer);
+	glBindBuffer(target, result.buffer);
+	if(persistent){
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, size, NULL, flags);
+		result.mapped = (u8*)glMapBufferRange(target, 0, size, flags);
+		ASSERT(result.mapped != NULL);
+	}else{
+		glBufferData(target, size, NULL, GL_STREAM_DRAW);
+	}
+	return result;
+}
+
+// NOTE: Writes `data` to the current segment and returns its offset in
+// the buffer. The buffer is left bound to its target.
+static
+usize gl_stream_buffer_upload(GLStreamBuffer *S, const void *data, usize size){
+	ASSERT(size <= S->segment_size);
+	i32 segment = S->segment;
+	usize offset = segment * S->segment_size;
+	glBindBuffer(S->target, S->buffer);
+	if(S->persistent){
+		if(S->fences[segment] != NULL){
+			gl_wait_fence(S->fences[segment]);
+			S->fences[segment] = NULL;
+		}
+		memcpy(S->mapped + offset, data, size);
+	}else{
+		if(segment == 0){
+			glBufferData(S->target, GL_STREAM_SEGMENTS * S->segment_size,
+				NULL, GL_STREAM_DRAW);
+		}
+		glBufferSubData(S->target, offset, size, data);
+	}
+	gl_bytes_uploaded += size;
+	return offset;
+}
+
+// NOTE: Must be called after the draw calls that read the current
+// segment. It moves on to the next one.
+static
+void gl_stream_buffer_advance(GLStreamBuffer *S){
+	if(S->persistent)
+		S->fences[S->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	S->segment = (S->segment + 1) % GL_STREAM_SEGMENTS;
+}
+
 // ----------------------------------------------------------------
 // Line Renderer
 // ----------------------------------------------------------------
@@ -134,26 +252,51 @@ struct LineVertex{
 	Vector3 color;
 };
 
+// NOTE: Points are drawn as instances of a small wireframe cube so each
+// one only costs a position and a color instead of its 12 edges.
+#define LINER_POINT_HALF_SIZE 0.02f
+#define LINER_POINT_MESH_VERTICES 24
+
+struct PointInstance{
+	Vector3 position;
+	Vector3 color;
+};
+
 struct LineRenderer{
 	GLuint program;
+	GLuint point_program;
 
-	GLuint vbuffer;
-	usize vbuffer_size;
+	GLuint line_vao;
+	GLuint point_vao;
+	GLuint point_mesh;
 
-	GLuint ubuffer;
-	usize ubuffer_size;
+	GLStreamBuffer vbuffer;
+	GLStreamBuffer pbuffer;
+	GLStreamBuffer ubuffer;
+	i32 max_vertices;
+	i32 max_points;
+};
 
+// NOTE: CPU side lines and points. They are filled by the simulation
+// thread and only read by the render thread after being handed over
+// through a `LineTripleBuffer`.
+struct LineBuffer{
 	i32 max_vertices;
 	i32 num_vertices;
 	LineVertex *vertices;
+
+	i32 max_points;
+	i32 num_points;
+	PointInstance *points;
 };
 
 struct RenderParams{
 	Matrix4 pv;
 };
 
-LineRenderer liner_init(i32 max_lines){
+LineRenderer liner_init(i32 max_lines, i32 max_points){
 	ASSERT(max_lines > 0 && max_lines <= 0x00FFFFFF);
+	ASSERT(max_points > 0 && max_points <= 0x00FFFFFF);
 	static const char *vshader =
 		"#version 420\n"
 		"layout(location = 0) in vec3 in_position;\n"
@@ -165,6 +308,18 @@ LineRenderer liner_init(i32 max_lines){
 		"	gl_Position = pv * vec4(in_position, 1.0);\n"
 		"	out_color = in_color;\n"
 		"}\n";
+	static const char *point_vshader =
+		"#version 420\n"
+		"layout(location = 0) in vec3 in_offset;\n"
+		"layout(location = 1) in vec3 in_position;\n"
+		"layout(location = 2) in vec3 in_color;\n"
+		"layout(location = 0) out vec3 out_color;\n"
+		"layout(std140, row_major, binding = 0)\n"
+		"uniform RenderParams { mat4 pv; };\n"
+		"void main(){\n"
+		"	gl_Position = pv * vec4(in_position + in_offset, 1.0);\n"
+		"	out_color = in_color;\n"
+		"}\n";
 	static const char *fshader =
 		"#version 420\n"
 		"layout(location = 0) in vec3 in_color;\n"
@@ -172,69 +327,139 @@ LineRenderer liner_init(i32 max_lines){
 		"void main(){ out_color = in_color; }\n";
 
 
-	// create shader program
+	// create shader programs
 	GLuint program = gl_create_program("line_renderer", vshader, fshader);
-	ASSERT(program != 0);
-
-	// create vertex buffer
-	GLuint vbuffer;
+	GLuint point_program = gl_create_program("line_renderer_points", point_vshader, fshader);
+	ASSERT(program != 0 && point_program != 0);
+
+	// create point mesh (the 12 edges of a cube centered at the origin)
+	Vector3 corners[8];
+	for(i32 i = 0; i < 8; i += 1){
+		corners[i] = make_v3(
+			(i & 1) ? +LINER_POINT_HALF_SIZE : -LINER_POINT_HALF_SIZE,
+			(i & 2) ? +LINER_POINT_HALF_SIZE : -LINER_POINT_HALF_SIZE,
+			(i & 4) ? +LINER_POINT_HALF_SIZE : -LINER_POINT_HALF_SIZE);
+	}
+	static const i32 edges[LINER_POINT_MESH_VERTICES] = {
+		0, 1, 1, 3, 3, 2, 2, 0,		// bottom edges
+		0, 4, 1, 5, 3, 7, 2, 6,		// middle edges
+		4, 5, 5, 7, 7, 6, 6, 4,		// top edges
+	};
+	Vector3 mesh[LINER_POINT_MESH_VERTICES];
+	for(i32 i = 0; i < LINER_POINT_MESH_VERTICES; i += 1)
+		mesh[i] = corners[edges[i]];
+
+	GLuint point_mesh;
+	glGenBuffers(1, &point_mesh);
+	glBindBuffer(GL_ARRAY_BUFFER, point_mesh);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(mesh), mesh, GL_STATIC_DRAW);
+
+	// create vertex, instance and uniform stream buffers (uniform segments
+	// must respect the offset alignment to be bound with glBindBufferRange)
+	bool persistent = gl_has_buffer_storage();
 	i32 max_vertices = 2 * max_lines;
 	usize vbuffer_size = sizeof(LineVertex) * max_vertices;
-	glGenBuffers(1, &vbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, vbuffer);
-	glBufferData(GL_ARRAY_BUFFER, vbuffer_size, NULL, GL_STATIC_DRAW);
-
-	// create uniform buffer for render params
-	GLuint ubuffer;
-	usize ubuffer_size = sizeof(RenderParams);
-	glGenBuffers(1, &ubuffer);
-	glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubuffer);
-	glBufferData(GL_UNIFORM_BUFFER, ubuffer_size, NULL, GL_STATIC_DRAW);
+	usize pbuffer_size = sizeof(PointInstance) * max_points;
+	GLint ubuffer_alignment;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubuffer_alignment);
+	ASSERT(ubuffer_alignment > 0);
+	usize ubuffer_size = sizeof(RenderParams) + (usize)ubuffer_alignment - 1;
+	ubuffer_size -= ubuffer_size % (usize)ubuffer_alignment;
 
 	LineRenderer result;
+	result.vbuffer = gl_stream_buffer_init(GL_ARRAY_BUFFER, vbuffer_size, persistent);
+	result.pbuffer = gl_stream_buffer_init(GL_ARRAY_BUFFER, pbuffer_size, persistent);
+	result.ubuffer = gl_stream_buffer_init(GL_UNIFORM_BUFFER, ubuffer_size, persistent);
+
+	// create vertex arrays (the attributes point at the start of their
+	// buffers and never change, each draw picks its segment with the first
+	// vertex or the base instance instead)
+	GLuint vaos[2];
+	glGenVertexArrays(2, vaos);
+	glBindVertexArray(vaos[1]);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glBindBuffer(GL_ARRAY_BUFFER, point_mesh);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vector3), (void*)0);
+	glBindBuffer(GL_ARRAY_BUFFER, result.pbuffer.buffer);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(PointInstance), (void*)offsetof(PointInstance, position));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(PointInstance), (void*)offsetof(PointInstance, color));
+	glVertexAttribDivisor(1, 1);
+	glVertexAttribDivisor(2, 1);
+	glBindVertexArray(vaos[0]);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, result.vbuffer.buffer);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, position));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)offsetof(LineVertex, color));
+
 	result.program = program;
-	result.vbuffer = vbuffer;
-	result.vbuffer_size = vbuffer_size;
-	result.ubuffer = ubuffer;
-	result.ubuffer_size = ubuffer_size;
+	result.point_program = point_program;
+	result.line_vao = vaos[0];
+	result.point_vao = vaos[1];
+	result.point_mesh = point_mesh;
 	result.max_vertices = max_vertices;
+	result.max_points = max_points;
+	return result;
+}
+
+LineBuffer liner_buffer_init(i32 max_lines, i32 max_points){
+	ASSERT(max_lines > 0 && max_lines <= 0x00FFFFFF);
+	ASSERT(max_points > 0 && max_points <= 0x00FFFFFF);
+	LineBuffer result;
+	result.max_vertices = 2 * max_lines;
 	result.num_vertices = 0;
-	result.vertices = (LineVertex*)malloc_nofail(vbuffer_size);
+	result.vertices = (LineVertex*)malloc_nofail(sizeof(LineVertex) * result.max_vertices);
+	result.max_points = max_points;
+	result.num_points = 0;
+	result.points = (PointInstance*)malloc_nofail(sizeof(PointInstance) * max_points);
 	return result;
 }
 
-void liner_draw(LineRenderer *L, RenderParams *render_params){
-	u32 num_vertices = L->num_vertices;
-	if(num_vertices == 0)
+// NOTE: Only uploads the vertices and points in use, to the next segment
+// of their stream buffers. `lines` is left untouched so the same buffer
+// can be drawn again if the simulation didn't produce a new one in time.
+void liner_draw(LineRenderer *L, LineBuffer *lines, RenderParams *render_params){
+	i32 num_vertices = lines->num_vertices;
+	i32 num_points = lines->num_points;
+	if(num_vertices == 0 && num_points == 0)
 		return;
+	ASSERT(num_vertices <= L->max_vertices);
+	ASSERT(num_points <= L->max_points);
+
+	usize uoffset = gl_stream_buffer_upload(&L->ubuffer,
+		render_params, sizeof(RenderParams));
+	glBindBufferRange(GL_UNIFORM_BUFFER, 0, L->ubuffer.buffer,
+		uoffset, sizeof(RenderParams));
+
+	if(num_vertices > 0){
+		glUseProgram(L->program);
+		glBindVertexArray(L->line_vao);
+		usize voffset = gl_stream_buffer_upload(&L->vbuffer,
+			lines->vertices, sizeof(LineVertex) * num_vertices);
+		glDrawArrays(GL_LINES, (GLint)(voffset / sizeof(LineVertex)), num_vertices);
+	}
 
-	//glBindBuffer(GL_UNIFORM_BUFFER, L->ubuffer);
-	//glBufferData(GL_UNIFORM_BUFFER, L->ubuffer_size, NULL, GL_STATIC_DRAW);
-	//glBufferData(GL_UNIFORM_BUFFER, L->ubuffer_size, render_params, GL_STATIC_DRAW);
-
-	ASSERT(L->ubuffer_size == sizeof(RenderParams));
-
-	glUseProgram(L->program);
-
-	glBindBufferBase(GL_UNIFORM_BUFFER, 0, L->ubuffer);
-	glBufferData(GL_UNIFORM_BUFFER, L->ubuffer_size, NULL, GL_STATIC_DRAW);
-	glBufferData(GL_UNIFORM_BUFFER, L->ubuffer_size, render_params, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ARRAY_BUFFER, L->vbuffer);
-	glBufferData(GL_ARRAY_BUFFER, L->vbuffer_size, NULL, GL_STATIC_DRAW);
-	glBufferData(GL_ARRAY_BUFFER, L->vbuffer_size, L->vertices, GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex), (void*)12);
-
-	glDrawArrays(GL_LINES, 0, num_vertices);
+	if(num_points > 0){
+		// NOTE: Segments are a whole number of instances so the segment
+		// is selected with the base instance.
+		glUseProgram(L->point_program);
+		glBindVertexArray(L->point_vao);
+		usize poffset = gl_stream_buffer_upload(&L->pbuffer,
+			lines->points, sizeof(PointInstance) * num_points);
+		glDrawArraysInstancedBaseInstance(GL_LINES, 0, LINER_POINT_MESH_VERTICES,
+			num_points, (GLuint)(poffset / sizeof(PointInstance)));
+	}
 
-	L->num_vertices = 0;
+	gl_stream_buffer_advance(&L->ubuffer);
+	if(num_vertices > 0)
+		gl_stream_buffer_advance(&L->vbuffer);
+	if(num_points > 0)
+		gl_stream_buffer_advance(&L->pbuffer);
 }
 
-void liner_push_line(LineRenderer *L, Vector3 p1, Vector3 p2, Vector3 color){
+void liner_push_line(LineBuffer *L, Vector3 p1, Vector3 p2, Vector3 color){
 	ASSERT((L->num_vertices + 2) <= L->max_vertices);
 	LineVertex *v = &L->vertices[L->num_vertices];
 	L->num_vertices += 2;
@@ -244,37 +469,66 @@ void liner_push_line(LineRenderer *L, Vector3 p1, Vector3 p2, Vector3 color){
 	v[1].color = color;
 }
 
-void liner_push_point(LineRenderer *L, Vector3 point, Vector3 color){
-	// point rect
-	Vector3 min = make_v3(-0.02f, -0.02f, -0.02f) + point;
-	Vector3 max = make_v3(+0.02f, +0.02f, +0.02f) + point;
-
-	// bottom vertices
-	Vector3 b1 = make_v3(min.x, min.y, min.z);
-	Vector3 b2 = make_v3(max.x, min.y, min.z);
-	Vector3 b3 = make_v3(max.x, max.y, min.z);
-	Vector3 b4 = make_v3(min.x, max.y, min.z);
-	// top vertices
-	Vector3 t1 = make_v3(min.x, min.y, max.z);
-	Vector3 t2 = make_v3(max.x, min.y, max.z);
-	Vector3 t3 = make_v3(max.x, max.y, max.z);
-	Vector3 t4 = make_v3(min.x, max.y, max.z);
-
-	// bottom edges
-	liner_push_line(L, b1, b2, color);
-	liner_push_line(L, b2, b3, color);
-	liner_push_line(L, b3, b4, color);
-	liner_push_line(L, b4, b1, color);
-	// middle edges
-	liner_push_line(L, b1, t1, color);
-	liner_push_line(L, b2, t2, color);
-	liner_push_line(L, b3, t3, color);
-	liner_push_line(L, b4, t4, color);
-	// top edges
-	liner_push_line(L, t1, t2, color);
-	liner_push_line(L, t2, t3, color);
-	liner_push_line(L, t3, t4, color);
-	liner_push_line(L, t4, t1, color);
+void liner_push_point(LineBuffer *L, Vector3 point, Vector3 color){
+	ASSERT((L->num_points + 1) <= L->max_points);
+	PointInstance *p = &L->points[L->num_points];
+	L->num_points += 1;
+	p->position = point;
+	p->color = color;
+}
+
+// ----------------------------------------------------------------
+// Line Triple Buffer
+// ----------------------------------------------------------------
+
+// NOTE: Lock free handover of line buffers from the simulation thread
+// to the render thread. Each side owns one buffer and the third one is
+// in `shared`, along with a flag telling whether it holds lines the
+// render thread hasn't seen yet. Publishing and acquiring swap the
+// owned buffer with the shared one so neither side ever waits on the
+// other and the render thread always gets the latest complete buffer.
+#define LINE_TRIPLE_BUFFER_FRESH 0x04
+
+struct LineTripleBuffer{
+	LineBuffer buffers[3];
+	i32 write_index;			// simulation thread only
+	i32 read_index;				// render thread only
+	volatile u32 shared;
+};
+
+LineTripleBuffer liner_triple_buffer_init(i32 max_lines, i32 max_points){
+	LineTripleBuffer result;
+	for(i32 i = 0; i < 3; i += 1)
+		result.buffers[i] = liner_buffer_init(max_lines, max_points);
+	result.write_index = 0;
+	result.shared = 1;
+	result.read_index = 2;
+	return result;
+}
+
+static INLINE
+LineBuffer *liner_write_buffer(LineTripleBuffer *T){
+	return &T->buffers[T->write_index];
+}
+
+// NOTE: Hands the write buffer over and returns the next one to fill.
+static
+LineBuffer *liner_publish(LineTripleBuffer *T){
+	u32 prev = atomic_exchange_u32(&T->shared,
+		(u32)T->write_index | LINE_TRIPLE_BUFFER_FRESH);
+	T->write_index = (i32)(prev & 0x03);
+	return &T->buffers[T->write_index];
+}
+
+// NOTE: Returns the latest published buffer, which is the one from the
+// last call if nothing new was published since.
+static
+LineBuffer *liner_acquire(LineTripleBuffer *T){
+	if(atomic_load_u32(&T->shared) & LINE_TRIPLE_BUFFER_FRESH){
+		u32 prev = atomic_exchange_u32(&T->shared, (u32)T->read_index);
+		T->read_index = (i32)(prev & 0x03);
+	}
+	return &T->buffers[T->read_index];
 }
 
 // ----------------------------------------------------------------
@@ -358,26 +612,91 @@ Matrix4 cam_mat4(Camera *cam){
 // ----------------------------------------------------------------
 
 static
-void gjk_draw_polygon_points(LineRenderer *L,
+void gjk_draw_polygon_points(LineBuffer *L,
 		GJK_Polygon *p, Vector3 color){
 	for(i32 i = 0; i < p->num_points; i += 1)
-		liner_push_point(L, p->points[i], color);
+		liner_push_point(L, gjk_polygon_point(p, i), color);
 }
 
+// NOTE: Only draws the polygons that are visible from `frustum`.
 static
-void gjk_draw_minkowski_points(LineRenderer *L,
+void gjk_draw_visible_polygons(LineBuffer *L, GJK_Frustum *frustum,
+		GJK_Polygon *p1, GJK_Polygon *p2, Vector3 color){
+	GJK_Polygon polygons[2] = { *p1, *p2 };
+	AABB bounds[2];
+	bool visible[2];
+	for(i32 i = 0; i < 2; i += 1){
+		Vector3 point = gjk_polygon_point(&polygons[i], 0);
+		bounds[i] = make_aabb(point, point);
+		for(i32 j = 1; j < polygons[i].num_points; j += 1){
+			point = gjk_polygon_point(&polygons[i], j);
+			bounds[i] = aabb_union(bounds[i], make_aabb(point, point));
+		}
+	}
+
+	gjk_frustum_cull(NULL, frustum, polygons, bounds, 2, visible, NULL, NULL);
+	for(i32 i = 0; i < 2; i += 1){
+		if(visible[i])
+			gjk_draw_polygon_points(L, &polygons[i], color);
+	}
+}
+
+static
+void gjk_draw_minkowski_points(LineBuffer *L,
 		GJK_Polygon *p1, GJK_Polygon *p2, Vector3 color){
 	for(i32 i = 0; i < p1->num_points; i += 1){
 		for(i32 j = 0; j < p2->num_points; j += 1){
 			liner_push_point(L,
-				p1->points[i] - p2->points[j],
+				gjk_polygon_point(p1, i) - gjk_polygon_point(p2, j),
 				color);
 		}
 	}
 }
 
+// NOTE: Draws the hull of `p1 - p2` and the final gjk simplex instead of
+// every pairwise difference (see `gjk_minkowski_hull_build`).
+#define GJK_DEMO_HULL_DIRECTIONS 256
+
+static
+void gjk_draw_minkowski_hull(LineBuffer *L,
+		GJK_Polygon *p1, GJK_Polygon *p2,
+		Vector3 hull_color, Vector3 simplex_color){
+	// NOTE: The simplex and the origin are at most 6 lines and 5 points
+	// and are drawn first so a full buffer only cuts the hull short.
+	if((L->num_vertices + 12) > L->max_vertices
+	|| (L->num_points + 5) > L->max_points)
+		return;
+
+	Vector3 simplex[4];
+	i32 num_points;
+	gjk_simplex(p1, p2, simplex, &num_points);
+	for(i32 i = 0; i < num_points; i += 1){
+		liner_push_point(L, simplex[i], simplex_color);
+		for(i32 j = i + 1; j < num_points; j += 1)
+			liner_push_line(L, simplex[i], simplex[j], simplex_color);
+	}
+	liner_push_point(L, v3_zero, make_v3(1.0f, 1.0f, 1.0f));
+
+	GJK_Hull hull;
+	if(gjk_minkowski_hull_build(p1, p2, GJK_DEMO_HULL_DIRECTIONS, &hull)){
+		// NOTE: Each edge shows up once in each direction. A face pushes
+		// at most 3 lines.
+		for(i32 i = 0; i < hull.num_faces; i += 1){
+			if((L->num_vertices + 6) > L->max_vertices)
+				break;
+			for(i32 k = 0; k < 3; k += 1){
+				u32 a = hull.faces[i * 3 + k];
+				u32 b = hull.faces[i * 3 + (k + 1) % 3];
+				if(a < b)
+					liner_push_line(L, hull.points[a], hull.points[b], hull_color);
+			}
+		}
+		gjk_hull_free(&hull);
+	}
+}
+
 static
-void gjk_draw_closest_feature(LineRenderer *L,
+void gjk_draw_closest_feature(LineBuffer *L,
 		Vector3 *points, i32 num_points, Vector3 color){
 	ASSERT(num_points >= 1 && num_points <= 3);
 	switch(num_points){
@@ -395,9 +714,10 @@ void gjk_draw_closest_feature(LineRenderer *L,
 	}
 }
 
-void gjk_test1(LineRenderer *L,
+void gjk_test1(LineBuffer *L, GJK_Frustum *frustum,
 		bool swap_polygon_order,
 		bool draw_minkowski_points,
+		bool draw_minkowski_hull,
 		Vector3 position1, f32 angle2){
 
 	Vector3 points1[] = {
@@ -430,8 +750,8 @@ void gjk_test1(LineRenderer *L,
 	// rotate points2
 	ASSERT(angle2 >= 0.0f && angle2 <= CONST_2PI);
 	Quaternion rotation = quat_angle_axis(angle2, make_v3(0.0f, 0.0f, 1.0f));
-	for(i32 i = 0; i < NARRAY(points2); i += 1)
-		points2[i] = v3_rotate(points2[i], rotation);
+	transform_points(make_transform(rotation, v3_zero),
+		points2, points2, NARRAY(points2));
 
 	GJK_Polygon p1 = make_gjk_polygon(points1, NARRAY(points1));
 	GJK_Polygon p2 = make_gjk_polygon(points2, NARRAY(points2));
@@ -450,14 +770,19 @@ void gjk_test1(LineRenderer *L,
 	Vector3 polygon_color = result.overlap
 		? make_v3(0.90f, 0.00f, 0.10f)
 		: make_v3(0.75f, 0.15f, 0.65f);
-	gjk_draw_polygon_points(L, &p1, polygon_color);
-	gjk_draw_polygon_points(L, &p2, polygon_color);
+	gjk_draw_visible_polygons(L, frustum, &p1, &p2, polygon_color);
 
 	if(draw_minkowski_points){
 		gjk_draw_minkowski_points(L, &p1, &p2,
 			make_v3(1.0f, 1.0f, 1.0f));
 	}
 
+	if(draw_minkowski_hull){
+		gjk_draw_minkowski_hull(L, &p1, &p2,
+			make_v3(0.35f, 0.35f, 0.80f),
+			make_v3(1.0f, 0.85f, 0.0f));
+	}
+
 	if(!result.overlap){
 		Vector3 color1 = make_v3(0.5f, 0.65f, 0.15f);
 		gjk_draw_closest_feature(L, result.points1,
@@ -474,9 +799,10 @@ void gjk_test1(LineRenderer *L,
 	}
 }
 
-void gjk_test2(LineRenderer *L,
+void gjk_test2(LineBuffer *L, GJK_Frustum *frustum,
 		bool swap_polygon_order,
 		bool draw_minkowski_points,
+		bool draw_minkowski_hull,
 		Vector3 position1, f32 angle2){
 	Vector3 points1[] = {
 		make_v3(-1.0f, +1.0f, -1.0f) + position1,
@@ -493,8 +819,8 @@ void gjk_test2(LineRenderer *L,
 
 	// rotate points2
 	Quaternion rotation = quat_angle_axis(angle2, make_v3(0.0f, 0.0f, 1.0f));
-	for(i32 i = 0; i < NARRAY(points2); i += 1)
-		points2[i] = v3_rotate(points2[i], rotation);
+	transform_points(make_transform(rotation, v3_zero),
+		points2, points2, NARRAY(points2));
 
 	GJK_Polygon p1 = make_gjk_polygon(points1, NARRAY(points1));
 	GJK_Polygon p2 = make_gjk_polygon(points2, NARRAY(points2));
@@ -510,13 +836,472 @@ void gjk_test2(LineRenderer *L,
 	Vector3 polygon_color = result
 		? make_v3(0.90f, 0.00f, 0.10f)
 		: make_v3(0.75f, 0.15f, 0.65f);
-	gjk_draw_polygon_points(L, &p1, polygon_color);
-	gjk_draw_polygon_points(L, &p2, polygon_color);
+	gjk_draw_visible_polygons(L, frustum, &p1, &p2, polygon_color);
 
 	if(draw_minkowski_points){
 		gjk_draw_minkowski_points(L, &p1, &p2,
 			make_v3(1.0f, 1.0f, 1.0f));
 	}
+
+	if(draw_minkowski_hull){
+		gjk_draw_minkowski_hull(L, &p1, &p2,
+			make_v3(0.35f, 0.35f, 0.80f),
+			make_v3(1.0f, 0.85f, 0.0f));
+	}
+}
+
+// ----------------------------------------------------------------
+// Stress Scene
+// ----------------------------------------------------------------
+
+// NOTE: Load test for the whole collision step. `num_bodies` random
+// convex bodies with a mix of hull sizes fly around inside a box and
+// bounce off its walls, so every body moves on every step and the
+// bounds, broadphase and narrowphase are all redone. It runs windowed
+// (test 3) or headless with `-stress <bodies> -steps <steps>`.
+#define STRESS_DEFAULT_BODIES 4096
+#define STRESS_DEFAULT_SEED 0x12345678
+#define STRESS_MARGIN 0.05f
+#define STRESS_MAX_SPEED 2.0f							// m/s
+#define STRESS_MAX_TURN_SPEED ((f32)CONST_PI)			// rad/s
+
+static const i32 stress_hull_sizes[] = { 4, 8, 16, 32, 64, 128 };
+#define STRESS_NUM_HULL_SIZES ((i32)NARRAY(stress_hull_sizes))
+
+struct StressBody{
+	Vector3 velocity;
+	Vector3 turn_axis;
+	f32 turn_speed;
+	Transform transform;
+};
+
+// NOTE: Totals over a number of steps. Queries are the narrowphase
+// `gjk` calls, which are the pairs that weren't reused from the last
+// step.
+struct StressStats{
+	i32 num_steps;
+	i64 num_pairs;
+	i64 num_queries;
+	i64 num_contacts;
+	f64 move_time;
+	f64 step_time;
+	f64 phase_times[GJK_WORLD_NUM_PHASES];
+};
+
+struct StressScene{
+	i32 num_bodies;
+	f32 extent;
+	u32 rng_state;
+
+	Vector3 *points;
+	GJK_Polygon *polygons;
+	StressBody *bodies;
+	GJK_World world;
+	JobSystem *jobs;
+
+	// NOTE: Stats since the last report and since the start.
+	StressStats interval;
+	StressStats total;
+
+	// NOTE: Scratch for drawing.
+	GJK_Polygon *visible_polygons;
+	AABB *visible_bounds;
+	bool *visible;
+	bool *touching;
+};
+
+static
+f32 stress_random(StressScene *scene){
+	// NOTE: xorshift32 mapped to [-1, 1]
+	u32 x = scene->rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	scene->rng_state = x;
+	return (f32)((f64)x / (f64)UINT32_MAX) * 2.0f - 1.0f;
+}
+
+static
+Vector3 stress_random_v3(StressScene *scene){
+	f32 x = stress_random(scene);
+	f32 y = stress_random(scene);
+	f32 z = stress_random(scene);
+	return make_v3(x, y, z);
+}
+
+static
+Vector3 stress_random_direction(StressScene *scene){
+	while(true){
+		Vector3 v = stress_random_v3(scene);
+		f32 length2 = v3_dot(v, v);
+		if(length2 > 1.0e-2f && length2 <= 1.0f)
+			return v3_normalize(v);
+	}
+}
+
+// NOTE: Must be called on the thread that steps the scene since that's
+// the one waiting on the job system. `num_threads` may be 1 to run
+// everything on the calling thread.
+static
+void stress_init(StressScene *scene, i32 num_bodies, i32 num_threads, u32 seed){
+	ASSERT(num_bodies > 0 && seed != 0);
+	memset(scene, 0, sizeof(StressScene));
+	scene->num_bodies = num_bodies;
+	scene->rng_state = seed;
+
+	// NOTE: Bodies are about 1m across so this keeps a few of them
+	// touching each other for any count.
+	scene->extent = 1.5f * (f32)pow((f64)num_bodies, 1.0 / 3.0);
+
+	i32 num_points = 0;
+	for(i32 i = 0; i < num_bodies; i += 1)
+		num_points += stress_hull_sizes[i % STRESS_NUM_HULL_SIZES];
+	scene->points = (Vector3*)malloc_nofail(sizeof(Vector3) * num_points);
+	scene->polygons = (GJK_Polygon*)malloc_nofail(sizeof(GJK_Polygon) * num_bodies);
+	scene->bodies = (StressBody*)malloc_nofail(sizeof(StressBody) * num_bodies);
+	scene->visible_polygons = (GJK_Polygon*)malloc_nofail(sizeof(GJK_Polygon) * num_bodies);
+	scene->visible_bounds = (AABB*)malloc_nofail(sizeof(AABB) * num_bodies);
+	scene->visible = (bool*)malloc_nofail(sizeof(bool) * num_bodies);
+	scene->touching = (bool*)malloc_nofail(sizeof(bool) * num_bodies);
+
+	scene->world = gjk_world_create(num_bodies, STRESS_MARGIN);
+	scene->jobs = num_threads > 1 ? job_system_create(num_threads) : NULL;
+
+	// NOTE: Points on a random ellipsoid, so (almost) all of them are on
+	// the hull and the support functions see the full hull size.
+	Vector3 *points = scene->points;
+	for(i32 i = 0; i < num_bodies; i += 1){
+		i32 hull_size = stress_hull_sizes[i % STRESS_NUM_HULL_SIZES];
+		Vector3 radii = make_v3(
+			1.0f + 0.5f * stress_random(scene),
+			1.0f + 0.5f * stress_random(scene),
+			1.0f + 0.5f * stress_random(scene));
+		for(i32 j = 0; j < hull_size; j += 1){
+			Vector3 dir = stress_random_direction(scene);
+			points[j] = 0.5f * make_v3(dir.x * radii.x, dir.y * radii.y, dir.z * radii.z);
+		}
+		scene->polygons[i] = make_gjk_polygon(points, hull_size);
+		points += hull_size;
+
+		StressBody *body = &scene->bodies[i];
+		body->velocity = STRESS_MAX_SPEED * stress_random_v3(scene);
+		body->turn_axis = stress_random_direction(scene);
+		body->turn_speed = STRESS_MAX_TURN_SPEED * stress_random(scene);
+		body->transform = make_transform(
+			quat_angle_axis((f32)CONST_PI * stress_random(scene),
+				stress_random_direction(scene)),
+			scene->extent * stress_random_v3(scene));
+		gjk_world_add_body(&scene->world, &scene->polygons[i], body->transform);
+	}
+}
+
+static
+void stress_free(StressScene *scene){
+	if(scene->jobs != NULL)
+		job_system_destroy(scene->jobs);
+	gjk_world_free(&scene->world);
+	free(scene->points);
+	free(scene->polygons);
+	free(scene->bodies);
+	free(scene->visible_polygons);
+	free(scene->visible_bounds);
+	free(scene->visible);
+	free(scene->touching);
+	memset(scene, 0, sizeof(StressScene));
+}
+
+static
+void stress_stats_add(StressStats *stats, GJK_World *world,
+		f64 move_time, f64 step_time){
+	stats->num_steps += 1;
+	stats->num_pairs += world->num_pairs;
+	stats->num_queries += world->num_pairs - world->num_reused_pairs;
+	stats->num_contacts += world->num_contacts;
+	stats->move_time += move_time;
+	stats->step_time += step_time;
+	for(i32 i = 0; i < GJK_WORLD_NUM_PHASES; i += 1)
+		stats->phase_times[i] += world->phase_times[i];
+}
+
+static
+void stress_step(StressScene *scene, f32 dt){
+	f64 move_start = thread_time();
+	f32 extent = scene->extent;
+	for(i32 i = 0; i < scene->num_bodies; i += 1){
+		StressBody *body = &scene->bodies[i];
+		Vector3 position = body->transform.translation + dt * body->velocity;
+		f32 *p = &position.x;
+		f32 *v = &body->velocity.x;
+		for(i32 axis = 0; axis < 3; axis += 1){
+			if((p[axis] < -extent && v[axis] < 0.0f)
+			|| (p[axis] > extent && v[axis] > 0.0f))
+				v[axis] = -v[axis];
+		}
+
+		Quaternion turn = quat_angle_axis(body->turn_speed * dt, body->turn_axis);
+		body->transform = make_transform(
+			quat_normalize(turn * body->transform.rotation), position);
+		gjk_world_set_transform(&scene->world, i, body->transform);
+	}
+
+	f64 step_start = thread_time();
+	gjk_world_step(&scene->world, scene->jobs);
+	f64 step_end = thread_time();
+
+	f64 move_time = step_start - move_start;
+	f64 step_time = step_end - step_start;
+	stress_stats_add(&scene->interval, &scene->world, move_time, step_time);
+	stress_stats_add(&scene->total, &scene->world, move_time, step_time);
+}
+
+static
+void stress_print_stats(const char *label, StressStats *stats){
+	if(stats->num_steps == 0)
+		return;
+
+	f64 inv_steps = 1.0 / (f64)stats->num_steps;
+	f64 queries_per_second = stats->step_time > 0.0
+		? (f64)stats->num_queries / stats->step_time : 0.0;
+	LOG("%s: %d steps, %.3f ms/step, %.0f queries/s,"
+		" %.0f pairs/step, %.0f queries/step, %.0f contacts/step\n",
+		label, stats->num_steps, 1.0e3 * stats->step_time * inv_steps,
+		queries_per_second, (f64)stats->num_pairs * inv_steps,
+		(f64)stats->num_queries * inv_steps, (f64)stats->num_contacts * inv_steps);
+	LOG("%s: move = %.3f ms, bounds = %.3f ms, broadphase = %.3f ms,"
+		" narrowphase = %.3f ms, manifold = %.3f ms\n",
+		label, 1.0e3 * stats->move_time * inv_steps,
+		1.0e3 * stats->phase_times[GJK_WORLD_PHASE_BOUNDS] * inv_steps,
+		1.0e3 * stats->phase_times[GJK_WORLD_PHASE_BROADPHASE] * inv_steps,
+		1.0e3 * stats->phase_times[GJK_WORLD_PHASE_NARROWPHASE] * inv_steps,
+		1.0e3 * stats->phase_times[GJK_WORLD_PHASE_MANIFOLD] * inv_steps);
+}
+
+static
+void stress_draw_aabb(LineBuffer *L, const AABB &box, Vector3 color){
+	Vector3 corners[8];
+	for(i32 i = 0; i < 8; i += 1){
+		corners[i] = make_v3(
+			(i & 1) ? box.max.x : box.min.x,
+			(i & 2) ? box.max.y : box.min.y,
+			(i & 4) ? box.max.z : box.min.z);
+	}
+
+	// NOTE: Each edge joins two corners that differ in a single bit.
+	for(i32 i = 0; i < 8; i += 1){
+		for(i32 bit = 1; bit < 8; bit <<= 1){
+			if((i & bit) == 0)
+				liner_push_line(L, corners[i], corners[i | bit], color);
+		}
+	}
+}
+
+// NOTE: Draws the bounds of the bodies visible from `frustum` until the
+// line buffer is full. Bodies overlapping another body are highlighted.
+static
+void stress_draw(LineBuffer *L, GJK_Frustum *frustum, StressScene *scene){
+	GJK_World *world = &scene->world;
+	for(i32 i = 0; i < world->num_bodies; i += 1){
+		scene->visible_polygons[i] = world->bodies[i].world;
+		scene->visible_bounds[i] = world->bodies[i].bounds;
+		scene->touching[i] = false;
+	}
+	for(i32 i = 0; i < world->num_contacts; i += 1){
+		GJK_WorldContact *contact = &world->contacts[i];
+		if(contact->result.overlap){
+			scene->touching[contact->body1] = true;
+			scene->touching[contact->body2] = true;
+		}
+	}
+
+	gjk_frustum_cull(scene->jobs, frustum, scene->visible_polygons,
+		scene->visible_bounds, world->num_bodies, scene->visible, NULL, NULL);
+
+	Vector3 body_color = make_v3(0.75f, 0.15f, 0.65f);
+	Vector3 touching_color = make_v3(0.90f, 0.00f, 0.10f);
+	for(i32 i = 0; i < world->num_bodies; i += 1){
+		if(!scene->visible[i])
+			continue;
+		if((L->num_vertices + 24) > L->max_vertices)
+			break;
+		stress_draw_aabb(L, scene->visible_bounds[i],
+			scene->touching[i] ? touching_color : body_color);
+	}
+}
+
+// NOTE: Runs `num_steps` fixed steps without a window and prints the
+// stats once a second and for the whole run.
+static
+void stress_run_headless(i32 num_bodies, i32 num_threads, u32 seed, i32 num_steps){
+	const f32 dt = 1.0f / 60.0f;
+	LOG("stress: %d bodies, %d threads, %d steps, seed = 0x%08X\n",
+		num_bodies, num_threads, num_steps, seed);
+
+	StressScene scene;
+	stress_init(&scene, num_bodies, num_threads, seed);
+	f64 report_time = thread_time() + 1.0;
+	for(i32 step = 0; step < num_steps; step += 1){
+		stress_step(&scene, dt);
+		if(thread_time() >= report_time){
+			stress_print_stats("interval", &scene.interval);
+			memset(&scene.interval, 0, sizeof(StressStats));
+			report_time += 1.0;
+		}
+	}
+	stress_print_stats("total", &scene.total);
+	stress_free(&scene);
+}
+
+// ----------------------------------------------------------------
+// Simulation
+// ----------------------------------------------------------------
+
+// NOTE: Everything the simulation needs from the render thread. It's
+// copied under `Simulation::input_lock` once per step.
+struct SimInput{
+	i32 gjk_test;
+	bool draw_minkowski_points;
+	bool draw_minkowski_hull;
+	bool swap_polygon_order;
+
+	bool polygon1_move_n;
+	bool polygon1_move_w;
+	bool polygon1_move_s;
+	bool polygon1_move_e;
+	bool polygon1_move_up;
+	bool polygon1_move_down;
+
+	Camera camera;
+};
+
+// NOTE: The simulation runs the gjk tests on its own thread as fast as
+// it can and publishes the resulting lines, so it isn't tied to the
+// display refresh rate. The render thread only handles input and draws
+// the latest lines.
+struct Simulation{
+	Mutex *input_lock;
+	SimInput input;
+	LineTripleBuffer lines;
+
+	f32 aspect_ratio;
+	f32 yfov;
+	f32 znear;
+	f32 zfar;
+
+	// NOTE: Stress scene parameters. The scene is created the first time
+	// test 3 is selected.
+	i32 stress_bodies;
+	i32 stress_threads;
+	u32 stress_seed;
+
+	volatile u32 num_steps;
+	volatile u32 quit;
+};
+
+static
+void sim_thread_main(void *arg){
+	Simulation *sim = (Simulation*)arg;
+
+	const f32 polygon1_move_speed = 1.0f;					// m/s
+	const f32 polygon2_turn_speed = (f32)(CONST_PI / 4);	// rad/s
+
+	Vector3 polygon1_position = {};
+	f32 polygon2_angle = 0.0f;
+
+	StressScene stress = {};
+	bool stress_ready = false;
+	f64 stress_report_time = 0.0;
+
+	LineBuffer *lines = liner_write_buffer(&sim->lines);
+	f64 inv_counter_frequency = 1 / (f64)SDL_GetPerformanceFrequency();
+	u64 prev_counter = SDL_GetPerformanceCounter();
+	while(atomic_load_u32(&sim->quit) == 0){
+		u64 cur_counter = SDL_GetPerformanceCounter();
+		f32 dt = (f32)((cur_counter - prev_counter) * inv_counter_frequency);
+		prev_counter = cur_counter;
+
+		SimInput input;
+		mutex_lock(sim->input_lock);
+		input = sim->input;
+		mutex_unlock(sim->input_lock);
+
+		{
+			i32 move_x = 0;
+			i32 move_y = 0;
+			i32 move_z = 0;
+			if(input.polygon1_move_n)
+				move_y += 1;
+			if(input.polygon1_move_w)
+				move_x -= 1;
+			if(input.polygon1_move_s)
+				move_y -= 1;
+			if(input.polygon1_move_e)
+				move_x += 1;
+			if(input.polygon1_move_up)
+				move_z += 1;
+			if(input.polygon1_move_down)
+				move_z -= 1;
+
+			if(move_x || move_y || move_z){
+				f32 move_amount = polygon1_move_speed * dt;
+				Vector3 dir = v3_normalize(make_v3((f32)move_x, (f32)move_y, (f32)move_z));
+				polygon1_position += move_amount * dir;
+			}
+		}
+
+		{
+			f32 turn_amount = polygon2_turn_speed * dt;
+			polygon2_angle += turn_amount;
+			if(polygon2_angle > CONST_2PI)
+				polygon2_angle = 0.0f;
+		}
+
+		Camera *camera = &input.camera;
+		GJK_Frustum frustum = make_gjk_frustum(camera->position,
+			camera->direction, camera->up, sim->aspect_ratio,
+			sim->yfov, sim->znear, sim->zfar);
+		lines->num_vertices = 0;
+		lines->num_points = 0;
+		switch(input.gjk_test){
+			default:
+			case 1:
+				gjk_test1(lines, &frustum,
+					input.swap_polygon_order,
+					input.draw_minkowski_points,
+					input.draw_minkowski_hull,
+					polygon1_position, polygon2_angle);
+				break;
+			case 2:
+				gjk_test2(lines, &frustum,
+					input.swap_polygon_order,
+					input.draw_minkowski_points,
+					input.draw_minkowski_hull,
+					polygon1_position, polygon2_angle);
+				break;
+			case 3:
+				if(!stress_ready){
+					stress_init(&stress, sim->stress_bodies,
+						sim->stress_threads, sim->stress_seed);
+					stress_ready = true;
+					stress_report_time = thread_time() + 1.0;
+				}
+
+				// NOTE: Don't let a stall (like the scene being created)
+				// throw the bodies out of their box.
+				stress_step(&stress, dt < 0.05f ? dt : 0.05f);
+				stress_draw(lines, &frustum, &stress);
+				if(thread_time() >= stress_report_time){
+					stress_print_stats("stress", &stress.interval);
+					memset(&stress.interval, 0, sizeof(StressStats));
+					stress_report_time = thread_time() + 1.0;
+				}
+				break;
+		}
+		lines = liner_publish(&sim->lines);
+		atomic_add_u32(&sim->num_steps, 1);
+	}
+
+	if(stress_ready)
+		stress_free(&stress);
 }
 
 // ----------------------------------------------------------------
@@ -524,6 +1309,46 @@ void gjk_test2(LineRenderer *L,
 // ----------------------------------------------------------------
 
 int SDL_main(int argc, char **argv){
+	// command line
+	// ----------------------------------------------------------------
+	i32 stress_bodies = STRESS_DEFAULT_BODIES;
+	i32 stress_threads = thread_hardware_concurrency();
+	u32 stress_seed = STRESS_DEFAULT_SEED;
+	i32 stress_steps = 0;
+	bool stress = false;
+	bool usage = false;
+	if(stress_threads > JOB_MAX_WORKERS)
+		stress_threads = JOB_MAX_WORKERS;
+	for(i32 i = 1; i < argc; i += 1){
+		bool has_value = (i + 1) < argc;
+		if(strcmp(argv[i], "-stress") == 0 && has_value){
+			stress = true;
+			stress_bodies = atoi(argv[++i]);
+		}else if(strcmp(argv[i], "-steps") == 0 && has_value){
+			stress_steps = atoi(argv[++i]);
+		}else if(strcmp(argv[i], "-threads") == 0 && has_value){
+			stress_threads = atoi(argv[++i]);
+		}else if(strcmp(argv[i], "-seed") == 0 && has_value){
+			stress_seed = (u32)strtoul(argv[++i], NULL, 0);
+		}else{
+			usage = true;
+		}
+	}
+
+	if(usage || stress_bodies <= 0 || stress_steps < 0 || stress_seed == 0
+	|| stress_threads < 1 || stress_threads > JOB_MAX_WORKERS){
+		fprintf(stdout, "usage: gjk [-stress bodies] [-steps steps]"
+			" [-threads threads] [-seed seed]\n");
+		return 1;
+	}
+
+	// NOTE: Runs the stress scene without a window when a step count is
+	// given, for benchmarking.
+	if(stress_steps > 0){
+		stress_run_headless(stress_bodies, stress_threads, stress_seed, stress_steps);
+		return 0;
+	}
+
 	if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0)
 		return -1;
 
@@ -569,21 +1394,26 @@ int SDL_main(int argc, char **argv){
 
 	// rendering state
 	// ----------------------------------------------------------------
-	LineRenderer L = liner_init(UINT16_MAX);
+	const i32 max_lines = UINT16_MAX;
+	const i32 max_points = 1 << 18;
+	LineRenderer L = liner_init(max_lines, max_points);
 	Camera camera = cam_init(
 		make_v3(0.0f, 0.0f, 16.0f),
 		make_v3(0.0f, 0.0f, -1.0f),
 		make_v3(0.0f, 1.0f, 0.0f));
-	Matrix4 projection = mat4_perspective(16.0f / 9.0f, (f32)(CONST_PI / 4), 0.01f, 100.0f);
+	const f32 aspect_ratio = 16.0f / 9.0f;
+	const f32 yfov = (f32)(CONST_PI / 4);
+	const f32 znear = 0.01f;
+	const f32 zfar = 100.0f;
+	Matrix4 projection = mat4_perspective(aspect_ratio, yfov, znear, zfar);
 
 	// input state
 	// ----------------------------------------------------------------
 	i32 last_mouse_x, last_mouse_y;
 	SDL_GetMouseState(&last_mouse_x, &last_mouse_y);
 
-	i32 gjk_test = 1;
-	bool draw_minkowski_points = false;
-	bool swap_polygon_order = false;
+	SimInput input = {};
+	input.gjk_test = stress ? 3 : 1;
 
 	bool camera_move_forward = false;
 	bool camera_move_left = false;
@@ -592,28 +1422,34 @@ int SDL_main(int argc, char **argv){
 	bool camera_roll_left = false;
 	bool camera_roll_right = false;
 
-	bool polygon1_move_n = false;
-	bool polygon1_move_w = false;
-	bool polygon1_move_s = false;
-	bool polygon1_move_e = false;
-	bool polygon1_move_up = false;
-	bool polygon1_move_down = false;
-
 	const f32 camera_move_speed = 4.0f;						// m/s
 	const f32 camera_turn_speed = (f32)(CONST_PI / 10);		// rad/s
-	const f32 polygon1_move_speed = 1.0f;					// m/s
-	const f32 polygon2_turn_speed = (f32)(CONST_PI / 4);	// rad/s
 
-	Vector3 polygon1_position = {};
-	f32 polygon2_angle = 0.0f;
+	// simulation state
+	// ----------------------------------------------------------------
+	Simulation sim = {};
+	sim.input_lock = mutex_create();
+	sim.input = input;
+	sim.input.camera = camera;
+	sim.lines = liner_triple_buffer_init(max_lines, max_points);
+	sim.aspect_ratio = aspect_ratio;
+	sim.yfov = yfov;
+	sim.znear = znear;
+	sim.zfar = zfar;
+	sim.stress_bodies = stress_bodies;
+	sim.stress_threads = stress_threads;
+	sim.stress_seed = stress_seed;
+	Thread *sim_thread = thread_create(sim_thread_main, &sim);
 
 	// print controls
 	// ----------------------------------------------------------------
 	LOG("TESTS:\n");
 	LOG(" [1]: using gjk()\n");
 	LOG(" [2]: using gjk_collision_test()\n");
+	LOG(" [3]: stress scene with %d bodies (see -stress)\n", stress_bodies);
 	LOG("COMMANDS:\n");
 	LOG(" [M]: toggle minkowski sum points\n");
+	LOG(" [H]: toggle minkowski difference hull and gjk simplex\n");
 	LOG(" [X]: swap order of polygons in the minkowski sum\n");
 	LOG("CAMERA:\n");
 	LOG(" [W]: move forward\n");
@@ -649,13 +1485,15 @@ int SDL_main(int argc, char **argv){
 	u64 prev_counter = SDL_GetPerformanceCounter();
 	u64 cur_counter;
 	f64 frame_dt = 0.1;
-	while(true){
+	bool running = true;
+	while(running){
 		f32 dt = (f32)frame_dt;
 		SDL_Event ev;
 		while(SDL_PollEvent(&ev)){
 			switch(ev.type){
 				case SDL_QUIT:
-					return 0;
+					running = false;
+					break;
 				case SDL_KEYDOWN:
 				case SDL_KEYUP:{
 					bool keydown = (ev.key.state == SDL_PRESSED);
@@ -663,25 +1501,36 @@ int SDL_main(int argc, char **argv){
 						// tests
 						case '1':
 							if(keydown){
-								gjk_test = 1;
+								input.gjk_test = 1;
 								LOG("TEST = 1\n");
 							}
 							break;
 						case '2':
 							if(keydown){	
-								gjk_test = 2;
+								input.gjk_test = 2;
 								LOG("TEST = 2\n");
 							}
 							break;
+						case '3':
+							if(keydown){
+								input.gjk_test = 3;
+								LOG("TEST = 3\n");
+							}
+							break;
 						// variables
 						case 'm':
 							if(keydown){
-								draw_minkowski_points = !draw_minkowski_points;
+								input.draw_minkowski_points = !input.draw_minkowski_points;
+							}
+							break;
+						case 'h':
+							if(keydown){
+								input.draw_minkowski_hull = !input.draw_minkowski_hull;
 							}
 							break;
 						case 'x':
 							if(keydown){
-								swap_polygon_order = !swap_polygon_order;
+								input.swap_polygon_order = !input.swap_polygon_order;
 							}
 							break;
 
@@ -707,22 +1556,22 @@ int SDL_main(int argc, char **argv){
 
 						// polygon control
 						case SDLK_UP:
-							polygon1_move_n = keydown;
+							input.polygon1_move_n = keydown;
 							break;
 						case SDLK_LEFT:
-							polygon1_move_w = keydown;
+							input.polygon1_move_w = keydown;
 							break;
 						case SDLK_DOWN:
-							polygon1_move_s = keydown;
+							input.polygon1_move_s = keydown;
 							break;
 						case SDLK_RIGHT:
-							polygon1_move_e = keydown;
+							input.polygon1_move_e = keydown;
 							break;
 						case SDLK_PAGEUP:
-							polygon1_move_up = keydown;
+							input.polygon1_move_up = keydown;
 							break;
 						case SDLK_PAGEDOWN:
-							polygon1_move_down = keydown;
+							input.polygon1_move_down = keydown;
 							break;
 					}
 					break;
@@ -785,58 +1634,16 @@ int SDL_main(int argc, char **argv){
 			}
 		}
 
-		{
-			i32 move_x = 0;
-			i32 move_y = 0;
-			i32 move_z = 0;
-			if(polygon1_move_n)
-				move_y += 1;
-			if(polygon1_move_w)
-				move_x -= 1;
-			if(polygon1_move_s)
-				move_y -= 1;
-			if(polygon1_move_e)
-				move_x += 1;
-			if(polygon1_move_up)
-				move_z += 1;
-			if(polygon1_move_down)
-				move_z -= 1;
-
-			if(move_x || move_y || move_z){
-				f32 move_amount = polygon1_move_speed * dt;
-				Vector3 dir = v3_normalize(make_v3((f32)move_x, (f32)move_y, (f32)move_z));
-				polygon1_position += move_amount * dir;
-			}
-		}
+		// hand the input over to the simulation and draw its latest lines
+		input.camera = camera;
+		mutex_lock(sim.input_lock);
+		sim.input = input;
+		mutex_unlock(sim.input_lock);
 
-		{
-			f32 turn_amount = polygon2_turn_speed * dt;
-			polygon2_angle += turn_amount;
-			if(polygon2_angle > CONST_2PI)
-				polygon2_angle = 0.0f;
-		}
-
-		// update and render
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		switch(gjk_test){
-			default:
-			case 1:
-				gjk_test1(&L,
-					swap_polygon_order,
-					draw_minkowski_points,
-					polygon1_position, polygon2_angle);
-				break;
-			case 2:
-				gjk_test2(&L,
-					swap_polygon_order,
-					draw_minkowski_points,
-					polygon1_position, polygon2_angle);
-				break;
-		}
-
 		RenderParams render_params;
 		render_params.pv = projection * cam_mat4(&camera);
-		liner_draw(&L, &render_params);
+		liner_draw(&L, liner_acquire(&sim.lines), &render_params);
 		SDL_GL_SwapWindow(window);
 
 		// calculate frame time
@@ -848,8 +1655,11 @@ int SDL_main(int argc, char **argv){
 		{
 			static f64 frame_dt_cache[120];
 			static u32 frame_count = 0;
+			static f64 sim_dt = 0.0;
+			static u64 prev_bytes_uploaded = 0;
 
 			frame_dt_cache[frame_count++] = frame_dt;
+			sim_dt += frame_dt;
 			if(frame_count >= 120){
 				f64 avg, min, max;
 				avg = frame_dt_cache[0];
@@ -863,15 +1673,28 @@ int SDL_main(int argc, char **argv){
 				}
 				avg /= frame_count;
 
-				char fps_text[64];
+				u32 num_steps = atomic_exchange_u32(&sim.num_steps, 0);
+				f64 frame_kb = (f64)(gl_bytes_uploaded - prev_bytes_uploaded)
+					/ (1024.0 * frame_count);
+				prev_bytes_uploaded = gl_bytes_uploaded;
+
+				char fps_text[128];
 				// min frame_dt = max fps
 				// max frame_dt = min fps
-				snprintf(fps_text, 64,
-					"FPS: avg = %g, min = %g, max = %g\n",
-					1.0 / avg, 1.0 / max, 1.0 / min);
+				snprintf(fps_text, NARRAY(fps_text),
+					"FPS: avg = %g, min = %g, max = %g, SIM: %g steps/s,"
+					" UPLOAD: %.1f KB/frame\n",
+					1.0 / avg, 1.0 / max, 1.0 / min, num_steps / sim_dt,
+					frame_kb);
 				SDL_SetWindowTitle(window, fps_text);
 				frame_count = 0;
+				sim_dt = 0.0;
 			}
 		}
 	}
+
+	atomic_store_u32(&sim.quit, 1);
+	thread_join(sim_thread);
+	mutex_destroy(sim.input_lock);
+	return 0;
 }
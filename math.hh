@@ -4,6 +4,17 @@
 #include "common.hh"
 #include <math.h>
 
+// NOTE: Define MATH_SIMD=1 to use the SSE4.1 backend. It requires
+// Vector3 to be 16 bytes so any code that depends on its size (eg.
+// vertex layouts) should use `sizeof` and `offsetof`. The Matrix4
+// product will also use AVX if it's enabled with the compiler.
+#if MATH_SIMD
+#	include <smmintrin.h>
+#	if defined(__AVX__)
+#		include <immintrin.h>
+#	endif
+#endif
+
 // ----------------------------------------------------------------
 // i32 operations
 // ----------------------------------------------------------------
@@ -36,9 +47,146 @@ bool f32_cmp_zero(f32 value){
 	return f32_abs(value) < F32_EPSILON;
 }
 
+static INLINE
+f32 f32_min(f32 a, f32 b){
+	return a < b ? a : b;
+}
+
+static INLINE
+f32 f32_max(f32 a, f32 b){
+	return a > b ? a : b;
+}
+
+static INLINE
+f32 f32_clamp(f32 value, f32 min, f32 max){
+	return f32_min(f32_max(value, min), max);
+}
+
 // ----------------------------------------------------------------
 // Vector3
 // ----------------------------------------------------------------
+#if MATH_SIMD
+// NOTE: With the SIMD backend, Vector3 is padded to 16 bytes so it can
+// be used directly as a SSE register. The fourth lane is ignored by all
+// operations below and `make_v3` keeps it at zero.
+union Vector3{
+	struct{
+		f32 x, y, z;
+	};
+	__m128 m;
+};
+
+static Vector3 v3_zero = {};
+
+static INLINE
+Vector3 make_v3(__m128 m){
+	Vector3 result;
+	result.m = m;
+	return result;
+}
+
+static INLINE
+Vector3 make_v3(f32 x, f32 y, f32 z){
+	return make_v3(_mm_setr_ps(x, y, z, 0.0f));
+}
+
+static INLINE
+Vector3 operator-(const Vector3 &v){
+	return make_v3(_mm_sub_ps(_mm_setzero_ps(), v.m));
+}
+
+static INLINE
+Vector3 operator+(const Vector3 &a, const Vector3 &b){
+	return make_v3(_mm_add_ps(a.m, b.m));
+}
+
+static INLINE
+Vector3 operator-(const Vector3 &a, const Vector3 &b){
+	return make_v3(_mm_sub_ps(a.m, b.m));
+}
+
+static INLINE
+Vector3 operator*(const Vector3 &a, const Vector3 &b){
+	return make_v3(_mm_mul_ps(a.m, b.m));
+}
+
+static INLINE
+Vector3 operator*(f32 a, const Vector3 &b){
+	return make_v3(_mm_mul_ps(_mm_set1_ps(a), b.m));
+}
+
+static INLINE
+Vector3 operator*(const Vector3 &a, f32 b){
+	return make_v3(_mm_mul_ps(a.m, _mm_set1_ps(b)));
+}
+
+static INLINE
+bool operator>(const Vector3 &a, const Vector3 &b){
+	return (_mm_movemask_ps(_mm_cmpgt_ps(a.m, b.m)) & 0x7) == 0x7;
+}
+
+static INLINE
+bool operator<(const Vector3 &a, const Vector3 &b){
+	return (_mm_movemask_ps(_mm_cmplt_ps(a.m, b.m)) & 0x7) == 0x7;
+}
+
+static INLINE
+bool operator==(const Vector3 &a, const Vector3 &b){
+	return (_mm_movemask_ps(_mm_cmpeq_ps(a.m, b.m)) & 0x7) == 0x7;
+}
+
+// NOTE: `dpps` has a long latency on most CPUs so we only use it
+// when the result must be broadcast to all lanes. Otherwise we do
+// the horizontal sum with two shuffles.
+static INLINE
+__m128 v3_dot_ss(__m128 a, __m128 b){
+	__m128 m = _mm_mul_ps(a, b);
+	__m128 result = _mm_add_ss(m, _mm_movehdup_ps(m));
+	result = _mm_add_ss(result, _mm_movehl_ps(m, m));
+	return result;
+}
+
+static INLINE
+f32 v3_dot(const Vector3 &a, const Vector3 &b){
+	return _mm_cvtss_f32(v3_dot_ss(a.m, b.m));
+}
+
+static INLINE
+f32 v3_norm2(const Vector3 &v){
+	return v3_dot(v, v);
+}
+
+static INLINE
+f32 v3_norm(const Vector3 &v){
+	return _mm_cvtss_f32(_mm_sqrt_ss(v3_dot_ss(v.m, v.m)));
+}
+
+static INLINE
+Vector3 v3_normalize(const Vector3 &v){
+	// NOTE: `rsqrtps` is only accurate to ~12 bits so we do
+	// one Newton-Raphson step to get close to full precision:
+	//		r = r * (1.5 - 0.5 * norm2 * r * r)
+	__m128 norm2 = _mm_dp_ps(v.m, v.m, 0x7F);
+	ASSERT(_mm_cvtss_f32(norm2) > 0.0f);
+	__m128 r = _mm_rsqrt_ps(norm2);
+	__m128 half_norm2_r2 = _mm_mul_ps(
+		_mm_mul_ps(_mm_set1_ps(0.5f), norm2), _mm_mul_ps(r, r));
+	r = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), half_norm2_r2));
+	return make_v3(_mm_mul_ps(v.m, r));
+}
+
+static INLINE
+Vector3 v3_cross(const Vector3 &a, const Vector3 &b){
+	// NOTE: Same as a.yzx * b.zxy - a.zxy * b.yzx but computed
+	// as (a * b.yzx - a.yzx * b).yzx which needs only three
+	// shuffles. `tmp` is the cross product in zxy order.
+	__m128 a_yzx = _mm_shuffle_ps(a.m, a.m, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b_yzx = _mm_shuffle_ps(b.m, b.m, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 tmp = _mm_sub_ps(_mm_mul_ps(a.m, b_yzx), _mm_mul_ps(a_yzx, b.m));
+	return make_v3(_mm_shuffle_ps(tmp, tmp, _MM_SHUFFLE(3, 0, 2, 1)));
+}
+
+#else
 struct Vector3{
 	f32 x, y, z;
 };
@@ -108,26 +256,6 @@ Vector3 operator*(const Vector3 &a, f32 b){
 	return result;
 }
 
-static INLINE
-void operator+=(Vector3 &a, const Vector3 &b){
-	a = a + b;
-}
-
-static INLINE
-void operator-=(Vector3 &a, const Vector3 &b){
-	a = a - b;
-}
-
-static INLINE
-void operator*=(Vector3 &a, const Vector3 &b){
-	a = a * b;
-}
-
-static INLINE
-void operator*=(Vector3 &a, f32 b){
-	a = a * b;
-}
-
 static INLINE
 bool operator>(const Vector3 &a, const Vector3 &b){
 	return a.x > b.x && a.y > b.y && a.z > b.z;
@@ -155,11 +283,6 @@ f32 v3_norm(const Vector3 &v){
 	return sqrtf(norm2);
 }
 
-static INLINE
-bool v3_cmp_zero(const Vector3 &v){
-	return v3_norm2(v) < F32_EPSILON2;
-}
-
 static INLINE
 Vector3 v3_normalize(const Vector3 &v){
 	f32 norm = v3_norm(v);
@@ -182,6 +305,43 @@ Vector3 v3_cross(const Vector3 &a, const Vector3 &b){
 	result.z = a.x * b.y - a.y * b.x;
 	return result;
 }
+#endif
+
+static INLINE
+void operator+=(Vector3 &a, const Vector3 &b){
+	a = a + b;
+}
+
+static INLINE
+void operator-=(Vector3 &a, const Vector3 &b){
+	a = a - b;
+}
+
+static INLINE
+void operator*=(Vector3 &a, const Vector3 &b){
+	a = a * b;
+}
+
+static INLINE
+void operator*=(Vector3 &a, f32 b){
+	a = a * b;
+}
+
+// NOTE: Components are contiguous in both backends.
+static INLINE
+f32 v3_axis(const Vector3 &v, i32 axis){
+	return (&v.x)[axis];
+}
+
+static INLINE
+Vector3 v3_abs(const Vector3 &v){
+	return make_v3(fabsf(v.x), fabsf(v.y), fabsf(v.z));
+}
+
+static INLINE
+bool v3_cmp_zero(const Vector3 &v){
+	return v3_norm2(v) < F32_EPSILON2;
+}
 
 static INLINE
 Vector3 v3_triple_cross(const Vector3 &a, const Vector3 &b, const Vector3 &c){
@@ -197,6 +357,108 @@ Vector3 v3_triple_cross(const Vector3 &a, const Vector3 &b, const Vector3 &c){
 	return result;
 }
 
+// ----------------------------------------------------------------
+// Vector3d
+// ----------------------------------------------------------------
+// NOTE: This is a double precision version of Vector3 with only
+// the operations needed to refine results computed in f32.
+struct Vector3d{
+	f64 x, y, z;
+};
+
+static INLINE
+Vector3d make_v3d(f64 x, f64 y, f64 z){
+	Vector3d result;
+	result.x = x;
+	result.y = y;
+	result.z = z;
+	return result;
+}
+
+static INLINE
+Vector3d make_v3d(const Vector3 &v){
+	return make_v3d(v.x, v.y, v.z);
+}
+
+static INLINE
+Vector3 make_v3(const Vector3d &v){
+	return make_v3((f32)v.x, (f32)v.y, (f32)v.z);
+}
+
+static INLINE
+Vector3d operator-(const Vector3d &v){
+	return make_v3d(-v.x, -v.y, -v.z);
+}
+
+static INLINE
+Vector3d operator+(const Vector3d &a, const Vector3d &b){
+	return make_v3d(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+static INLINE
+Vector3d operator-(const Vector3d &a, const Vector3d &b){
+	return make_v3d(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+static INLINE
+Vector3d operator*(f64 a, const Vector3d &b){
+	return make_v3d(a * b.x, a * b.y, a * b.z);
+}
+
+static INLINE
+f64 v3d_dot(const Vector3d &a, const Vector3d &b){
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static INLINE
+Vector3d v3d_cross(const Vector3d &a, const Vector3d &b){
+	Vector3d result;
+	result.x = a.y * b.z - a.z * b.y;
+	result.y = a.z * b.x - a.x * b.z;
+	result.z = a.x * b.y - a.y * b.x;
+	return result;
+}
+
+static INLINE
+f64 v3d_norm(const Vector3d &v){
+	return sqrt(v3d_dot(v, v));
+}
+
+// ----------------------------------------------------------------
+// AABB
+// ----------------------------------------------------------------
+struct AABB{
+	Vector3 min;
+	Vector3 max;
+};
+
+static INLINE
+AABB make_aabb(const Vector3 &min, const Vector3 &max){
+	AABB result;
+	result.min = min;
+	result.max = max;
+	return result;
+}
+
+static INLINE
+bool aabb_overlap(const AABB &a, const AABB &b){
+	return a.min.x <= b.max.x && a.max.x >= b.min.x
+		&& a.min.y <= b.max.y && a.max.y >= b.min.y
+		&& a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static INLINE
+AABB aabb_union(const AABB &a, const AABB &b){
+	AABB result;
+	result.min.x = a.min.x < b.min.x ? a.min.x : b.min.x;
+	result.min.y = a.min.y < b.min.y ? a.min.y : b.min.y;
+	result.min.z = a.min.z < b.min.z ? a.min.z : b.min.z;
+	result.max.x = a.max.x > b.max.x ? a.max.x : b.max.x;
+	result.max.y = a.max.y > b.max.y ? a.max.y : b.max.y;
+	result.max.z = a.max.z > b.max.z ? a.max.z : b.max.z;
+	return result;
+}
+
 // ----------------------------------------------------------------
 // Quaternion
 // ----------------------------------------------------------------
@@ -222,6 +484,15 @@ static Quaternion operator*(const Quaternion &a, const Quaternion &b){
 	return result;
 }
 
+// NOTE: For unit quaternions this is the inverse rotation.
+static Quaternion quat_conjugate(const Quaternion &q){
+	return make_quat(q.w, -q.x, -q.y, -q.z);
+}
+
+static f32 quat_dot(const Quaternion &a, const Quaternion &b){
+	return a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
 static Quaternion quat_normalize(const Quaternion &q){
 	f32 norm2 = q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z;
 	f32 norm = 1.0f / sqrtf(norm2);
@@ -254,6 +525,12 @@ union Matrix4{
 		f32 m41, m42, m43, m44;
 	};
 #endif
+
+#if MATH_SIMD
+	// NOTE: These are rows if the matrix is row major and
+	// columns if it's column major.
+	__m128 r[4];
+#endif
 };
 
 static Matrix4 mat4_identity = {
@@ -263,6 +540,59 @@ static Matrix4 mat4_identity = {
 	0.0f, 0.0f, 0.0f, 1.0f
 };
 
+#if MATH_SIMD
+// NOTE: Returns coeffs.x * r[0] + coeffs.y * r[1]
+//	+ coeffs.z * r[2] + coeffs.w * r[3].
+static INLINE
+__m128 mat4_combine(__m128 coeffs, const __m128 *r){
+	__m128 result = _mm_mul_ps(_mm_shuffle_ps(coeffs, coeffs, 0x00), r[0]);
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(coeffs, coeffs, 0x55), r[1]));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(coeffs, coeffs, 0xAA), r[2]));
+	result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(coeffs, coeffs, 0xFF), r[3]));
+	return result;
+}
+
+#if defined(__AVX__)
+// NOTE: Same as above but for two sets of coefficients at once.
+static INLINE
+__m256 mat4_combine2(__m256 coeffs, const __m128 *r){
+	__m256 r0 = _mm256_broadcast_ps(&r[0]);
+	__m256 r1 = _mm256_broadcast_ps(&r[1]);
+	__m256 r2 = _mm256_broadcast_ps(&r[2]);
+	__m256 r3 = _mm256_broadcast_ps(&r[3]);
+	__m256 result = _mm256_mul_ps(_mm256_shuffle_ps(coeffs, coeffs, 0x00), r0);
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(coeffs, coeffs, 0x55), r1));
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(coeffs, coeffs, 0xAA), r2));
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(coeffs, coeffs, 0xFF), r3));
+	return result;
+}
+#endif
+
+static Matrix4 operator*(const Matrix4 &a, const Matrix4 &b){
+	// NOTE: For row major matrices, row i of the result is a linear
+	// combination of the rows of `b` with the coefficients in row i
+	// of `a`. For column major, it's the same with `a` and `b` swapped.
+#if MAT4_COLUMN_MAJOR
+	const Matrix4 &x = b;
+	const Matrix4 &y = a;
+#else
+	const Matrix4 &x = a;
+	const Matrix4 &y = b;
+#endif
+
+	Matrix4 result;
+#if defined(__AVX__)
+	_mm256_storeu_ps(&result.m[0], mat4_combine2(_mm256_loadu_ps(&x.m[0]), y.r));
+	_mm256_storeu_ps(&result.m[8], mat4_combine2(_mm256_loadu_ps(&x.m[8]), y.r));
+#else
+	result.r[0] = mat4_combine(x.r[0], y.r);
+	result.r[1] = mat4_combine(x.r[1], y.r);
+	result.r[2] = mat4_combine(x.r[2], y.r);
+	result.r[3] = mat4_combine(x.r[3], y.r);
+#endif
+	return result;
+}
+#else
 static Matrix4 operator*(const Matrix4 &a, const Matrix4 &b){
 	Matrix4 result;
 
@@ -288,6 +618,7 @@ static Matrix4 operator*(const Matrix4 &a, const Matrix4 &b){
 
 	return result;
 }
+#endif
 
 static Matrix4 mat4_scale(f32 s){
 	Matrix4 result = {};
@@ -368,13 +699,14 @@ static Quaternion quat_rotation_between(const Vector3 &a, const Vector3 &b){
 }
 
 static Vector3 v3_rotate(const Vector3 &v, const Quaternion &q){
-	Quaternion vq = make_quat(0.0f, v.x, v.y, v.z);
-	Quaternion qconj = make_quat(q.w, -q.x, -q.y, -q.z);
-	Quaternion tmp = q * vq * qconj;
-	Vector3 result;
-	result.x = tmp.x;
-	result.y = tmp.y;
-	result.z = tmp.z;
+	// NOTE: This is q * v * conj(q) expanded for an unit quaternion
+	// so we don't need the two quaternion products:
+	//		t = 2 * (u cross v)
+	//		result = v + w * t + u cross t
+	// where u = (q.x, q.y, q.z) and w = q.w.
+	Vector3 u = make_v3(q.x, q.y, q.z);
+	Vector3 t = 2.0f * v3_cross(u, v);
+	Vector3 result = v + q.w * t + v3_cross(u, t);
 	return result;
 }
 
@@ -405,11 +737,205 @@ static Matrix4 mat4_from_quat(const Quaternion &q){
 }
 
 static Vector3 operator*(const Matrix4 &m, const Vector3 &v){
+#if MATH_SIMD
+	__m128 v1 = _mm_blend_ps(v.m, _mm_set1_ps(1.0f), 0x8);
+#if MAT4_COLUMN_MAJOR
+	__m128 tmp = mat4_combine(v1, m.r);
+	return make_v3(_mm_blend_ps(tmp, _mm_setzero_ps(), 0x8));
+#else
+	// NOTE: Transposing is cheaper than doing three `dpps`.
+	__m128 cols[4] = { m.r[0], m.r[1], m.r[2], m.r[3] };
+	_MM_TRANSPOSE4_PS(cols[0], cols[1], cols[2], cols[3]);
+	__m128 tmp = mat4_combine(v1, cols);
+	return make_v3(_mm_blend_ps(tmp, _mm_setzero_ps(), 0x8));
+#endif
+#else
 	Vector3 result;
 	result.x = m.m11 * v.x + m.m12 * v.y + m.m13 * v.z + m.m14;
 	result.y = m.m21 * v.x + m.m22 * v.y + m.m23 * v.z + m.m24;
 	result.z = m.m31 * v.x + m.m32 * v.y + m.m33 * v.z + m.m34;
 	return result;
+#endif
+}
+
+// ----------------------------------------------------------------
+// Transform
+// ----------------------------------------------------------------
+struct Transform{
+	Quaternion rotation;
+	Vector3 translation;
+};
+
+static Transform make_transform(const Quaternion &rotation, const Vector3 &translation){
+	Transform result;
+	result.rotation = rotation;
+	result.translation = translation;
+	return result;
+}
+
+static Transform transform_identity(void){
+	return make_transform(make_quat(1.0f, 0.0f, 0.0f, 0.0f), v3_zero);
+}
+
+static Vector3 transform_point(const Transform &t, const Vector3 &p){
+	return v3_rotate(p, t.rotation) + t.translation;
+}
+
+static Vector3 transform_inverse_point(const Transform &t, const Vector3 &p){
+	return v3_rotate(p - t.translation, quat_conjugate(t.rotation));
+}
+
+// NOTE: `a * b` applies `b` first and then `a`.
+static Transform operator*(const Transform &a, const Transform &b){
+	Transform result;
+	result.rotation = a.rotation * b.rotation;
+	result.translation = v3_rotate(b.translation, a.rotation) + a.translation;
+	return result;
+}
+
+static Transform transform_inverse(const Transform &t){
+	Transform result;
+	result.rotation = quat_conjugate(t.rotation);
+	result.translation = -v3_rotate(t.translation, result.rotation);
+	return result;
+}
+
+static Matrix4 mat4_from_transform(const Transform &t){
+	Matrix4 result = mat4_from_quat(t.rotation);
+	result.m14 = t.translation.x;
+	result.m24 = t.translation.y;
+	result.m34 = t.translation.z;
+	return result;
+}
+
+// ----------------------------------------------------------------
+// Bulk Transforms
+// ----------------------------------------------------------------
+// NOTE: These apply a rigid transform to whole point arrays. The
+// rotation is converted into a 3x4 matrix once so each point costs
+// 9 multiplies and 9 adds instead of the two quaternion products in
+// `v3_rotate`. With the SIMD backend, points are processed 4 at a
+// time (8 for SoA if AVX is enabled). `in` and `out` may be the same
+// array but must not otherwise overlap.
+
+struct Vector3SoA{
+	f32 *x;
+	f32 *y;
+	f32 *z;
+};
+
+static INLINE
+Vector3SoA make_v3soa(f32 *x, f32 *y, f32 *z){
+	Vector3SoA result;
+	result.x = x;
+	result.y = y;
+	result.z = z;
+	return result;
+}
+
+#if MATH_SIMD
+// NOTE: `m` holds the 12 coefficients of the 3x4 matrix, each one
+// broadcast to all lanes, in the order m11, m12, m13, m14, m21, ...
+static INLINE
+void transform_x4(const __m128 *m, __m128 *x, __m128 *y, __m128 *z){
+	__m128 ix = *x, iy = *y, iz = *z;
+	*x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], ix), _mm_mul_ps(m[1], iy)),
+			_mm_add_ps(_mm_mul_ps(m[2], iz), m[3]));
+	*y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[4], ix), _mm_mul_ps(m[5], iy)),
+			_mm_add_ps(_mm_mul_ps(m[6], iz), m[7]));
+	*z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[8], ix), _mm_mul_ps(m[9], iy)),
+			_mm_add_ps(_mm_mul_ps(m[10], iz), m[11]));
+}
+
+#if defined(__AVX__)
+static INLINE
+void transform_x8(const __m256 *m, __m256 *x, __m256 *y, __m256 *z){
+	__m256 ix = *x, iy = *y, iz = *z;
+	*x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[0], ix), _mm256_mul_ps(m[1], iy)),
+			_mm256_add_ps(_mm256_mul_ps(m[2], iz), m[3]));
+	*y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[4], ix), _mm256_mul_ps(m[5], iy)),
+			_mm256_add_ps(_mm256_mul_ps(m[6], iz), m[7]));
+	*z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[8], ix), _mm256_mul_ps(m[9], iy)),
+			_mm256_add_ps(_mm256_mul_ps(m[10], iz), m[11]));
+}
+#endif
+#endif
+
+static void transform_points(const Transform &t,
+		const Vector3 *in, Vector3 *out, i32 count){
+	Matrix4 m = mat4_from_transform(t);
+	i32 i = 0;
+#if MATH_SIMD
+	__m128 coeffs[12] = {
+		_mm_set1_ps(m.m11), _mm_set1_ps(m.m12), _mm_set1_ps(m.m13), _mm_set1_ps(m.m14),
+		_mm_set1_ps(m.m21), _mm_set1_ps(m.m22), _mm_set1_ps(m.m23), _mm_set1_ps(m.m24),
+		_mm_set1_ps(m.m31), _mm_set1_ps(m.m32), _mm_set1_ps(m.m33), _mm_set1_ps(m.m34),
+	};
+	for(; (i + 4) <= count; i += 4){
+		// NOTE: Vector3 is 16 bytes with this backend so 4 points
+		// transpose into one register per coordinate.
+		__m128 x = in[i + 0].m;
+		__m128 y = in[i + 1].m;
+		__m128 z = in[i + 2].m;
+		__m128 w = in[i + 3].m;
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		transform_x4(coeffs, &x, &y, &z);
+		w = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		out[i + 0].m = x;
+		out[i + 1].m = y;
+		out[i + 2].m = z;
+		out[i + 3].m = w;
+	}
+#endif
+	for(; i < count; i += 1)
+		out[i] = m * in[i];
+}
+
+static void transform_points_soa(const Transform &t,
+		Vector3SoA in, Vector3SoA out, i32 count){
+	Matrix4 m = mat4_from_transform(t);
+	i32 i = 0;
+#if MATH_SIMD
+#if defined(__AVX__)
+	__m256 coeffs8[12] = {
+		_mm256_set1_ps(m.m11), _mm256_set1_ps(m.m12), _mm256_set1_ps(m.m13), _mm256_set1_ps(m.m14),
+		_mm256_set1_ps(m.m21), _mm256_set1_ps(m.m22), _mm256_set1_ps(m.m23), _mm256_set1_ps(m.m24),
+		_mm256_set1_ps(m.m31), _mm256_set1_ps(m.m32), _mm256_set1_ps(m.m33), _mm256_set1_ps(m.m34),
+	};
+	for(; (i + 8) <= count; i += 8){
+		__m256 x = _mm256_loadu_ps(&in.x[i]);
+		__m256 y = _mm256_loadu_ps(&in.y[i]);
+		__m256 z = _mm256_loadu_ps(&in.z[i]);
+		transform_x8(coeffs8, &x, &y, &z);
+		_mm256_storeu_ps(&out.x[i], x);
+		_mm256_storeu_ps(&out.y[i], y);
+		_mm256_storeu_ps(&out.z[i], z);
+	}
+#endif
+	__m128 coeffs[12] = {
+		_mm_set1_ps(m.m11), _mm_set1_ps(m.m12), _mm_set1_ps(m.m13), _mm_set1_ps(m.m14),
+		_mm_set1_ps(m.m21), _mm_set1_ps(m.m22), _mm_set1_ps(m.m23), _mm_set1_ps(m.m24),
+		_mm_set1_ps(m.m31), _mm_set1_ps(m.m32), _mm_set1_ps(m.m33), _mm_set1_ps(m.m34),
+	};
+	for(; (i + 4) <= count; i += 4){
+		__m128 x = _mm_loadu_ps(&in.x[i]);
+		__m128 y = _mm_loadu_ps(&in.y[i]);
+		__m128 z = _mm_loadu_ps(&in.z[i]);
+		transform_x4(coeffs, &x, &y, &z);
+		_mm_storeu_ps(&out.x[i], x);
+		_mm_storeu_ps(&out.y[i], y);
+		_mm_storeu_ps(&out.z[i], z);
+	}
+#endif
+	for(; i < count; i += 1){
+		f32 x = in.x[i];
+		f32 y = in.y[i];
+		f32 z = in.z[i];
+		out.x[i] = m.m11 * x + m.m12 * y + m.m13 * z + m.m14;
+		out.y[i] = m.m21 * x + m.m22 * y + m.m23 * z + m.m24;
+		out.z[i] = m.m31 * x + m.m32 * y + m.m33 * z + m.m34;
+	}
 }
 
 #endif //GJK_MATH_HH_
@@ -7,6 +7,12 @@
 #	define GL_ENUM(name, value)
 #endif
 
+// NOTE: Procedures that may be missing without failing `gl_load`. Their
+// pointer is NULL when they couldn't be loaded.
+#ifndef GL_OPTIONAL_PROC
+#	define GL_OPTIONAL_PROC(rettype, name, args) GL_PROC(rettype, name, args)
+#endif
+
 // debug output
 GL_ENUM(DEBUG_OUTPUT, 0x92E0)
 GL_PROC(void, DebugMessageCallback, (GLDEBUGPROC callback, const void *userParam))
@@ -44,6 +50,7 @@ GL_PROC(void, GetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *leng
 // draw calls
 GL_ENUM(LINES, 0x0001)
 GL_PROC(void, DrawArrays, (GLenum mode, GLint first, GLsizei count))
+GL_PROC(void, DrawArraysInstancedBaseInstance, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount, GLuint baseinstance))
 
 // vertex attributes
 GL_ENUM(FLOAT, 0x1406)
@@ -52,8 +59,10 @@ GL_PROC(void, BindVertexArray, (GLuint array))
 GL_PROC(void, DisableVertexAttribArray, (GLuint index))
 GL_PROC(void, EnableVertexAttribArray, (GLuint index))
 GL_PROC(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer))
+GL_PROC(void, VertexAttribDivisor, (GLuint index, GLuint divisor))
 
 // buffer
+GL_ENUM(STREAM_DRAW, 0x88E0)
 GL_ENUM(STATIC_DRAW, 0x88E4)
 GL_ENUM(ARRAY_BUFFER, 0x8892)
 GL_ENUM(UNIFORM_BUFFER, 0x8A11)
@@ -61,6 +70,32 @@ GL_PROC(void, GenBuffers, (GLsizei n, GLuint *buffers))
 GL_PROC(void, BindBuffer, (GLenum target, GLuint buffer))
 GL_PROC(void, BufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage))
 GL_PROC(void, BindBufferBase, (GLenum target, GLuint index, GLuint buffer))
+GL_PROC(void, BindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size))
+GL_PROC(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data))
+
+// buffer mapping
+GL_ENUM(MAP_WRITE_BIT, 0x0002)
+GL_ENUM(MAP_PERSISTENT_BIT, 0x0040)
+GL_ENUM(MAP_COHERENT_BIT, 0x0080)
+GL_ENUM(UNIFORM_BUFFER_OFFSET_ALIGNMENT, 0x8A34)
+GL_PROC(void*, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))
+GL_OPTIONAL_PROC(void, BufferStorage, (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags))
+
+// sync objects
+GL_ENUM(SYNC_FLUSH_COMMANDS_BIT, 0x00000001)
+GL_ENUM(SYNC_GPU_COMMANDS_COMPLETE, 0x9117)
+GL_ENUM(ALREADY_SIGNALED, 0x911A)
+GL_ENUM(TIMEOUT_EXPIRED, 0x911B)
+GL_ENUM(CONDITION_SATISFIED, 0x911C)
+GL_ENUM(WAIT_FAILED, 0x911D)
+GL_PROC(GLsync, FenceSync, (GLenum condition, GLbitfield flags))
+GL_PROC(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout))
+GL_PROC(void, DeleteSync, (GLsync sync))
+
+// get integer
+GL_ENUM(MAJOR_VERSION, 0x821B)
+GL_ENUM(MINOR_VERSION, 0x821C)
+GL_PROC(void, GetIntegerv, (GLenum pname, GLint *data))
 
 // get string
 GL_ENUM(VENDOR, 0x1F00)
@@ -74,3 +109,4 @@ GL_PROC(const GLubyte*, GetStringi, (GLenum name, GLuint index))
 
 #undef GL_ENUM
 #undef GL_PROC
+#undef GL_OPTIONAL_PROC
@@ -0,0 +1,188 @@
+#include "thread.hh"
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN 1
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#	include <time.h>
+#	include <unistd.h>
+#endif
+
+struct Thread{
+	ThreadProc proc;
+	void *arg;
+#if defined(_WIN32)
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+#if defined(_WIN32)
+static
+DWORD WINAPI thread_entry(LPVOID param){
+	Thread *thread = (Thread*)param;
+	thread->proc(thread->arg);
+	return 0;
+}
+#else
+static
+void *thread_entry(void *param){
+	Thread *thread = (Thread*)param;
+	thread->proc(thread->arg);
+	return NULL;
+}
+#endif
+
+Thread *thread_create(ThreadProc proc, void *arg){
+	Thread *thread = (Thread*)malloc(sizeof(Thread));
+	ASSERT(thread != NULL);
+	thread->proc = proc;
+	thread->arg = arg;
+#if defined(_WIN32)
+	thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+	ASSERT(thread->handle != NULL);
+#else
+	int error = pthread_create(&thread->handle, NULL, thread_entry, thread);
+	ASSERT(error == 0);
+#endif
+	return thread;
+}
+
+void thread_join(Thread *thread){
+#if defined(_WIN32)
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+	free(thread);
+}
+
+i32 thread_hardware_concurrency(void){
+#if defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (i32)info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (i32)count : 1;
+#endif
+}
+
+f64 thread_time(void){
+#if defined(_WIN32)
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1.0e-9;
+#endif
+}
+
+struct Semaphore{
+#if defined(_WIN32)
+	HANDLE handle;
+#else
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	i32 count;
+#endif
+};
+
+Semaphore *semaphore_create(i32 initial_count){
+	Semaphore *semaphore = (Semaphore*)malloc(sizeof(Semaphore));
+	ASSERT(semaphore != NULL);
+#if defined(_WIN32)
+	semaphore->handle = CreateSemaphoreA(NULL, initial_count, 0x7FFFFFFF, NULL);
+	ASSERT(semaphore->handle != NULL);
+#else
+	pthread_mutex_init(&semaphore->mutex, NULL);
+	pthread_cond_init(&semaphore->cond, NULL);
+	semaphore->count = initial_count;
+#endif
+	return semaphore;
+}
+
+void semaphore_destroy(Semaphore *semaphore){
+#if defined(_WIN32)
+	CloseHandle(semaphore->handle);
+#else
+	pthread_cond_destroy(&semaphore->cond);
+	pthread_mutex_destroy(&semaphore->mutex);
+#endif
+	free(semaphore);
+}
+
+void semaphore_wait(Semaphore *semaphore){
+#if defined(_WIN32)
+	WaitForSingleObject(semaphore->handle, INFINITE);
+#else
+	pthread_mutex_lock(&semaphore->mutex);
+	while(semaphore->count == 0)
+		pthread_cond_wait(&semaphore->cond, &semaphore->mutex);
+	semaphore->count -= 1;
+	pthread_mutex_unlock(&semaphore->mutex);
+#endif
+}
+
+void semaphore_post(Semaphore *semaphore, i32 count){
+	ASSERT(count > 0);
+#if defined(_WIN32)
+	ReleaseSemaphore(semaphore->handle, count, NULL);
+#else
+	pthread_mutex_lock(&semaphore->mutex);
+	semaphore->count += count;
+	if(count == 1)
+		pthread_cond_signal(&semaphore->cond);
+	else
+		pthread_cond_broadcast(&semaphore->cond);
+	pthread_mutex_unlock(&semaphore->mutex);
+#endif
+}
+
+struct Mutex{
+#if defined(_WIN32)
+	SRWLOCK lock;
+#else
+	pthread_mutex_t mutex;
+#endif
+};
+
+Mutex *mutex_create(void){
+	Mutex *mutex = (Mutex*)malloc(sizeof(Mutex));
+	ASSERT(mutex != NULL);
+#if defined(_WIN32)
+	InitializeSRWLock(&mutex->lock);
+#else
+	pthread_mutex_init(&mutex->mutex, NULL);
+#endif
+	return mutex;
+}
+
+void mutex_destroy(Mutex *mutex){
+#if !defined(_WIN32)
+	pthread_mutex_destroy(&mutex->mutex);
+#endif
+	free(mutex);
+}
+
+void mutex_lock(Mutex *mutex){
+#if defined(_WIN32)
+	AcquireSRWLockExclusive(&mutex->lock);
+#else
+	pthread_mutex_lock(&mutex->mutex);
+#endif
+}
+
+void mutex_unlock(Mutex *mutex){
+#if defined(_WIN32)
+	ReleaseSRWLockExclusive(&mutex->lock);
+#else
+	pthread_mutex_unlock(&mutex->mutex);
+#endif
+}
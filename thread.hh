@@ -0,0 +1,34 @@
+#ifndef GJK_THREAD_HH_
+#define GJK_THREAD_HH_ 1
+
+#include "common.hh"
+
+// NOTE: Minimal wrapper over the platform threads (Win32 or pthreads).
+// Threads must always be joined which also releases them.
+typedef void (*ThreadProc)(void *arg);
+struct Thread;
+
+Thread *thread_create(ThreadProc proc, void *arg);
+void thread_join(Thread *thread);
+i32 thread_hardware_concurrency(void);
+
+// NOTE: Monotonic clock in seconds, for timing.
+f64 thread_time(void);
+
+// NOTE: Counting semaphore.
+struct Semaphore;
+
+Semaphore *semaphore_create(i32 initial_count);
+void semaphore_destroy(Semaphore *semaphore);
+void semaphore_wait(Semaphore *semaphore);
+void semaphore_post(Semaphore *semaphore, i32 count);
+
+// NOTE: Non recursive mutex.
+struct Mutex;
+
+Mutex *mutex_create(void);
+void mutex_destroy(Mutex *mutex);
+void mutex_lock(Mutex *mutex);
+void mutex_unlock(Mutex *mutex);
+
+#endif //GJK_THREAD_HH_